@@ -1,27 +1,74 @@
 #include <iostream>
+#include <string>
 #include "board.h"
 #include "search.h"
 #include "pathfinding.h"
 
 
-int main()
+//Reproducible benchmark: fixed positions, seed and playout budget, so the
+//moves chosen must not change between runs and playouts per second can be
+//compared across builds.
+void Bench()
 {
+	Hax::Board b(11);
+	Hax::Search::Params params;
+	params.b = 0.012f;
+	params.earlyStop = false;
+	Hax::Search::Searcher searcher(b, 4, params);
+	searcher.Seed(1);
+
+	Hax::Search::Limits limits;
+	limits.playouts = 10000;
+	long long playouts = 0;
+	long long elapsed = 0;
+	for (int i = 0; i < 6; ++i)
+	{
+		int mov = searcher.Search(limits);
+		const Hax::Search::SearchInfo& info = searcher.Info();
+		std::cout << "Move " << mov << ": " << info.playouts << " playouts, " << info.nodes << " nodes, " << info.elapsed << " ms" << std::endl;
+		playouts += info.playouts;
+		elapsed += info.elapsed;
+		searcher.MakeMove(mov);
+	}
+
+	std::cout << "Playouts per second: " << playouts * 1000 / std::max(elapsed, 1LL) << std::endl;
+}
+
+
+int main(int argc, char** argv)
+{
+	if (argc > 1 && std::string(argv[1]) == "bench")
+	{
+		Bench();
+		return 0;
+	}
+
 	//Demo
 	Hax::Board b(11);
+	Hax::Search::Params params;
+	params.b = 0.012f;
+	Hax::Search::Searcher searcher(b, 6, params);
+	long long banked = 0;
 	while (Hax::Pathfinding::CheckWinState(b) == Hax::WinState::Ongoing)
 	{
-		int mov = Hax::Search::MonteCarloSearch(b, 5000, 6, 0.0f, 0.012f);
+		//Time not needed for settled decisions carries over to the next move
+		int mov = searcher.Search(5000 + banked);
+		banked = searcher.Info().saved;
 		std::cout << "Computer plays: " << mov << std::endl;
 		b.MakeMove(mov);
+		searcher.MakeMove(mov);
 
-		int x = 9999;
-		while (!b.IsLegalMove(x) || x > b.Area() || x < 0)
+		//Keep searching on the human's time
+		searcher.StartPondering();
+		int x = -1;
+		while (x < 0 || x >= b.Area() || !b.IsLegalMove(x))
 		{
 			std::cout << "Enter a move: ";
 			std::cin >> x;
 			std::cout << std::endl;
-			b.MakeMove(x);
 		}
+		b.MakeMove(x);
+		searcher.MakeMove(x);
 	}
 
 	std::cout << "Game over!" << std::endl;
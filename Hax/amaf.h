@@ -0,0 +1,93 @@
+/*
+ * AMAF (all moves as first) statistics shared by all search threads.
+ * 
+ * Each tree keeps AMAF statistics per node, so a thread only learns about
+ * a move once it has created the node it is played from. This table
+ * instead records every playout of every thread: how often each player
+ * won the games in which they played a cell at any point. New nodes can
+ * then start from the ensemble's opinion of their moves instead of from
+ * nothing.
+ * 
+ * Entries are keyed by player and cell, and optionally by the move played
+ * just before (the context), which tells answers to a particular move apart
+ * from cells that are good in general. Counts are updated with relaxed
+ * atomics. They are only used as priors, so a slightly stale read is harmless.
+*/
+
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include "debug.h"
+
+
+namespace Hax
+{
+	namespace Search
+	{
+		class AmafTable
+		{
+		public:
+			//Creates an empty table for a board of area cells. If useContext is
+			//true, statistics are kept separately for each previous move.
+			AmafTable(int area, bool useContext) :
+				area(area), contexts((useContext) ? area + 1 : 1), entries(new Entry[2 * contexts * area])
+			{
+				Clear();
+			}
+
+			//Context for a move whose previous move is unknown.
+			int NoContext() const
+			{
+				return area;
+			}
+
+			//Records that the given player played move after context in a
+			//game they went on to win (or lose).
+			void Update(bool white, int context, int move, bool win)
+			{
+				Entry& entry = entries[Index(white, context, move)];
+				entry.n.fetch_add(1, std::memory_order_relaxed);
+				if (win) entry.w.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			//Sets n and w to the games recorded for the given player playing
+			//move after context, and the number of them won.
+			void Get(bool white, int context, int move, float& n, float& w) const
+			{
+				const Entry& entry = entries[Index(white, context, move)];
+				n = (float)entry.n.load(std::memory_order_relaxed);
+				w = (float)entry.w.load(std::memory_order_relaxed);
+			}
+
+			//Must not be called while other threads update the table.
+			void Clear()
+			{
+				for (size_t i = 0; i < 2 * contexts * area; ++i)
+				{
+					entries[i].n.store(0, std::memory_order_relaxed);
+					entries[i].w.store(0, std::memory_order_relaxed);
+				}
+			}
+
+		private:
+			struct Entry
+			{
+				std::atomic<uint64_t> n;
+				std::atomic<uint64_t> w;
+			};
+
+			size_t Index(bool white, int context, int move) const
+			{
+				D(if (move < 0 || (size_t)move >= area || context < 0 || (size_t)context > area) throw std::out_of_range("Move out of range"));
+				size_t ctx = (contexts > 1) ? (size_t)context : 0;
+				return (((white) ? contexts : 0) + ctx) * area + move;
+			}
+
+			size_t area;
+			size_t contexts;
+			std::unique_ptr<Entry[]> entries;
+		};
+	}
+}
\ No newline at end of file
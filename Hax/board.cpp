@@ -1,13 +1,50 @@
 #include "board.h"
+#include "random.h"
 
 namespace Hax
 {
+	struct ZobristTable
+	{
+		ZobristTable()
+		{
+			Random rng(0x48617845ULL);
+			base = rng.Next();
+			for (uint64_t& key : white) key = rng.Next();
+			for (uint64_t& key : black) key = rng.Next();
+		}
+
+		uint64_t base;
+		uint64_t white[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+		uint64_t black[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+	};
+
+
+	const ZobristTable& _Zobrist()
+	{
+		static const ZobristTable table;
+		return table;
+	}
+
+
+	uint64_t ZobristKey(Hexagon color, int index)
+	{
+		D(if (color == Hexagon::Unoccupied) throw std::invalid_argument("Unoccupied hexagons have no key"));
+		return (color == Hexagon::White) ? _Zobrist().white[index] : _Zobrist().black[index];
+	}
+
+
+	uint64_t ZobristBase()
+	{
+		return _Zobrist().base;
+	}
+
+
 	bool operator==(const Board& l, const Board& r)
 	{
 		return l.board == r.board;
 	}
 
-	Board::Board(int length) : length(length), area(length * length), numOccupied(0), whiteToMove(true)
+	Board::Board(int length) : length(length), area(length * length), numOccupied(0), whiteToMove(true), hash(ZobristBase())
 	{
 		if (length <= 0 || length > MAX_BOARD_SIZE) throw std::invalid_argument("Board length must be positive");
 		
@@ -53,10 +90,16 @@ namespace Hax
 		return board[move] == Hexagon::Unoccupied;
 	}
 
+	uint64_t Board::Hash() const
+	{
+		return hash;
+	}
+
 	void Board::MakeMove(int move)
 	{
 		D(if (!IsLegalMove(move)) throw std::logic_error("Illegal move"));
 		board[move] = (whiteToMove) ? Hexagon::White : Hexagon::Black;
+		hash ^= ZobristKey(board[move], move);
 		whiteToMove = !whiteToMove;
 		++numOccupied;
 	}
@@ -64,6 +107,7 @@ namespace Hax
 	void Board::UndoMove(int move)
 	{
 		D(if (IsLegalMove(move)) throw std::logic_error("No move here to undo"));
+		hash ^= ZobristKey(board[move], move);
 		board[move] = Hexagon::Unoccupied;
 		whiteToMove = !whiteToMove;
 		--numOccupied;
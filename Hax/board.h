@@ -7,6 +7,9 @@
  * Throughout we denote White to be the first player to move.
  * 
  * Board is modelled as a 1D array for memory/cpu efficiency.
+ * 
+ * A Zobrist hash of the position is maintained incrementally by
+ * MakeMove and UndoMove for use as a transposition key.
 */
 
 
@@ -15,6 +18,7 @@
 #include <string>
 #include <stdexcept>
 #include <algorithm>
+#include <cstdint>
 #include "debug.h"
 
 
@@ -38,6 +42,12 @@ namespace Hax
 		};
 
 
+		//Returns the Zobrist key of a hexagon of the given color at board index.
+		//The hash of a position is the base key xored with the keys of its hexagons.
+		uint64_t ZobristKey(Hexagon color, int index);
+		uint64_t ZobristBase();
+
+
 		class Board
 		{
 		public:
@@ -68,12 +78,16 @@ namespace Hax
 
 			bool IsLegalMove(int move) const;
 
+			//Returns the Zobrist hash of the current position.
+			uint64_t Hash() const;
+
 		private:
 			std::vector<Hexagon> board;
 			int length;
 			int area;
 			int numOccupied;
 			bool whiteToMove;
+			uint64_t hash;
 		};
 
 
@@ -0,0 +1,106 @@
+/*
+ * Fenwick (binary indexed) tree over non-negative weights.
+ * 
+ * Supports changing one weight and drawing an index with probability
+ * proportional to its weight, both in O(log n), so a sampler over a set
+ * that changes one element at a time never needs to renormalise.
+ * 
+ * Weights are accumulated in double precision, but repeated updates still
+ * leave rounding error in the partial sums. Rebuild with Assign from time
+ * to time, and be prepared for a draw to land on an index of weight 0.
+*/
+
+
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "random.h"
+#include "debug.h"
+
+
+namespace Hax
+{
+	class FenwickTree
+	{
+	public:
+		FenwickTree() : top(0) {}
+
+		//Replaces all weights with weights[0, size).
+		void Assign(const float* weights, int size)
+		{
+			values.assign(weights, weights + size);
+			tree.assign(size + 1, 0.0);
+			for (int i = 1; i <= size; ++i)
+			{
+				tree[i] += values[i - 1];
+				int parent = i + (i & -i);
+				if (parent <= size) tree[parent] += tree[i];
+			}
+
+			top = 1;
+			while (top * 2 <= size) top *= 2;
+		}
+
+		int Size() const
+		{
+			return (int)values.size();
+		}
+
+		float Weight(int i) const
+		{
+			return values[i];
+		}
+
+		void Set(int i, float weight)
+		{
+			D(if (weight < 0.0f) throw std::invalid_argument("Weights must not be negative"));
+			double delta = (double)weight - values[i];
+			values[i] = weight;
+			for (int j = i + 1; j < (int)tree.size(); j += j & -j)
+			{
+				tree[j] += delta;
+			}
+		}
+
+		//Returns the sum of all weights.
+		double Total() const
+		{
+			double total = 0.0;
+			for (int j = Size(); j > 0; j -= j & -j)
+			{
+				total += tree[j];
+			}
+			return total;
+		}
+
+		//Returns the index whose range of cumulative weight contains target,
+		//for 0 <= target < Total().
+		int Find(double target) const
+		{
+			int pos = 0;
+			for (int step = top; step > 0; step /= 2)
+			{
+				if (pos + step < (int)tree.size() && tree[pos + step] <= target)
+				{
+					pos += step;
+					target -= tree[pos];
+				}
+			}
+			return std::min(pos, Size() - 1);
+		}
+
+		//Returns an index drawn with probability proportional to its weight.
+		//The weights must not all be 0.
+		int Sample(Random& rng) const
+		{
+			return Find(rng.Uniform() * Total());
+		}
+
+	private:
+		//values[i] is the weight of index i, and tree[j] the sum of the
+		//weights of indices [j - (j & -j), j).
+		std::vector<float> values;
+		std::vector<double> tree;
+		int top;
+	};
+}
\ No newline at end of file
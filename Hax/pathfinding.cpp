@@ -182,6 +182,81 @@ namespace Hax
 		}
 
 
+		//Breadth first search with 0/1 edge weights: entering an own cell is free
+		//and entering an empty cell costs one. Cells are processed one distance
+		//level at a time, so each cell is expanded once with its final distance.
+		void _EdgeDistance(const Board& board, bool white, bool fromStart, int* dist)
+		{
+			static thread_local std::vector<int> current;
+			static thread_local std::vector<int> next;
+			current.clear();
+			next.clear();
+
+			const static int xIncs[] = { -1, -1, 0,  0, 1,  1 };
+			const static int yIncs[] = { 0,  1, 1, -1, 0, -1 };
+			const Hexagon own = (white) ? Hexagon::White : Hexagon::Black;
+			const int edge = (fromStart) ? 0 : board.Length() - 1;
+
+			for (int i = 0; i < board.Area(); ++i)
+			{
+				dist[i] = UNREACHABLE;
+				int line = (white) ? _Row(i, board) : _Column(i, board);
+				if (line != edge || !(board[i] == own || board.IsLegalMove(i))) continue;
+
+				dist[i] = (board[i] == own) ? 0 : 1;
+				if (dist[i] == 0) current.push_back(i);
+				else next.push_back(i);
+			}
+
+			for (int level = 0; !current.empty() || !next.empty(); ++level)
+			{
+				for (size_t k = 0; k < current.size(); ++k)
+				{
+					int pos = current[k];
+					if (dist[pos] != level) continue;
+
+					for (int j = 0; j < 6; ++j)
+					{
+						if (!_IsWithinBounds(xIncs[j], yIncs[j], pos, board)) continue;
+						int neighbour = _Traverse(xIncs[j], yIncs[j], pos, board);
+						if (!(board[neighbour] == own || board.IsLegalMove(neighbour))) continue;
+
+						int cost = (board[neighbour] == own) ? 0 : 1;
+						if (level + cost >= dist[neighbour]) continue;
+						dist[neighbour] = level + cost;
+						if (cost == 0) current.push_back(neighbour);
+						else next.push_back(neighbour);
+					}
+				}
+
+				current.swap(next);
+				next.clear();
+			}
+		}
+
+
+		void EdgeDistances(const Board& board, bool white, int* toStart, int* toEnd)
+		{
+			_EdgeDistance(board, white, true, toStart);
+			_EdgeDistance(board, white, false, toEnd);
+		}
+
+
+		int ConnectionDistance(const Board& board, bool white)
+		{
+			static thread_local int toEnd[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+			_EdgeDistance(board, white, false, toEnd);
+
+			int best = UNREACHABLE;
+			for (int i = 0; i < board.Area(); ++i)
+			{
+				int line = (white) ? _Row(i, board) : _Column(i, board);
+				if (line == 0) best = std::min(best, toEnd[i]);
+			}
+			return best;
+		}
+
+
 		WinState CheckWinState(const Board& board, bool includeVirtual)
 		{
 			int minToCheck = 2 * board.Length() - 1;
@@ -37,6 +37,30 @@ namespace Hax
 		 * paths are counted as wins.
 		*/
 		WinState CheckWinState(const Board& board, bool includeVirtual = false);
+
+
+		//Distance given to cells (and positions) a player cannot connect through.
+		const int UNREACHABLE = 1 << 20;
+
+
+		/*
+		 * Computes, for every cell, the fewest empty cells the given player must
+		 * fill to connect that cell to each of their two edges. The cell itself
+		 * counts if it is empty. Opponent cells are UNREACHABLE.
+		 * 
+		 * toStart: Output array of board.Area() distances to the top edge (White)
+		 *          or left edge (Black).
+		 * 
+		 * toEnd: As toStart, for the bottom (White) or right (Black) edge.
+		*/
+		void EdgeDistances(const Board& board, bool white, int* toStart, int* toEnd);
+
+
+		/*
+		 * Returns the fewest empty cells the given player must fill to connect
+		 * their edges (0 if already connected), or UNREACHABLE if they cannot.
+		*/
+		int ConnectionDistance(const Board& board, bool white);
 	}
 }
 
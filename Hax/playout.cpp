@@ -0,0 +1,353 @@
+#include <cmath>
+#include <algorithm>
+#include "playout.h"
+
+namespace Hax
+{
+	namespace Playout
+	{
+		//Pattern weights relative to an ordinary move.
+		//Moves touching stones of both players, where fights happen.
+		const float CONTACT_WEIGHT = 2.0f;
+
+		//Moves into one carrier of a two-bridge whose other carrier is empty.
+		//Intruding is usually answered, and filling our own wastes a move.
+		const float CARRIER_WEIGHT = 0.5f;
+
+		//Moves enclosed by one player's stones, which rarely matter.
+		const float DEAD_WEIGHT = 0.25f;
+
+		//Draws rejected before a pattern-weighted move is accepted regardless.
+		const int MAX_TRIES = 8;
+
+
+		float _PatternWeight(int pattern, bool white)
+		{
+			const int own = (int)((white) ? Hexagon::White : Hexagon::Black);
+			const int empty = (int)Hexagon::Unoccupied;
+			int cells[6];
+			int numOwn = 0;
+			int numEmpty = 0;
+			for (int d = 0; d < 6; ++d)
+			{
+				cells[d] = (pattern >> (2 * d)) & 3;
+				if (cells[d] == own) ++numOwn;
+				else if (cells[d] == empty) ++numEmpty;
+			}
+
+			int numOpp = 6 - numOwn - numEmpty;
+			if (numEmpty == 0 && (numOwn == 0 || numOpp == 0)) return DEAD_WEIGHT;
+
+			float weight = 1.0f;
+			if (numOwn > 0 && numOpp > 0) weight *= CONTACT_WEIGHT;
+			for (int d = 0; d < 6; ++d)
+			{
+				int before = cells[(d + 5) % 6];
+				int after = cells[(d + 1) % 6];
+				if (cells[d] == empty && before != empty && before == after)
+				{
+					weight *= CARRIER_WEIGHT;
+					break;
+				}
+			}
+			return weight;
+		}
+
+
+		struct PatternTable
+		{
+			PatternTable() : max(0.0f)
+			{
+				for (int pattern = 0; pattern < PATTERNS; ++pattern)
+				{
+					weights[0][pattern] = _PatternWeight(pattern, true);
+					weights[1][pattern] = _PatternWeight(pattern, false);
+					max = std::max(max, std::max(weights[0][pattern], weights[1][pattern]));
+				}
+			}
+
+			float weights[2][PATTERNS];
+			float max;
+		};
+
+
+		const PatternTable& _Patterns()
+		{
+			static const PatternTable table;
+			return table;
+		}
+
+
+		//Neighbours of every cell for every board length, six per cell going
+		//round it, with cells off the board as the negated edge owner.
+		struct NeighbourTable
+		{
+			NeighbourTable()
+			{
+				//Directions in order round a cell, so those either side of
+				//direction d are its two neighbours shared with the cell beyond d.
+				const static int xIncs[] = { 1,  1,  0, -1, -1, 0 };
+				const static int yIncs[] = { 0, -1, -1,  0,  1, 1 };
+				for (int length = 1; length <= MAX_BOARD_SIZE; ++length)
+				{
+					std::vector<int>& neighbours = cells[length];
+					neighbours.resize(6 * length * length);
+					for (int cell = 0; cell < length * length; ++cell)
+					{
+						for (int d = 0; d < 6; ++d)
+						{
+							int x = cell % length + xIncs[d];
+							int y = cell / length + yIncs[d];
+							int& neighbour = neighbours[6 * cell + d];
+							if (y < 0 || y >= length) neighbour = -(int)Hexagon::White;
+							else if (x < 0 || x >= length) neighbour = -(int)Hexagon::Black;
+							else neighbour = y * length + x;
+						}
+					}
+				}
+			}
+
+			std::vector<int> cells[MAX_BOARD_SIZE + 1];
+		};
+
+
+		const NeighbourTable& _Neighbours()
+		{
+			static const NeighbourTable table;
+			return table;
+		}
+
+
+		//Returns the six neighbours of cell on board.
+		const int* _Around(const Board& board, int cell)
+		{
+			return &_Neighbours().cells[board.Length()][6 * cell];
+		}
+
+
+		Policy::Policy(int length, const Settings& settings) :
+			settings(settings), index(length * length), remaining(0)
+		{
+			replies[0].assign(MAX_BOARD_SIZE * MAX_BOARD_SIZE, -1);
+			replies[1].assign(MAX_BOARD_SIZE * MAX_BOARD_SIZE, -1);
+			if (settings.mast)
+			{
+				float weight = std::exp(0.5f / settings.mastTemperature);
+				for (int player = 0; player < 2; ++player)
+				{
+					mastGames[player].assign(length * length, 0.0f);
+					mastWins[player].assign(length * length, 0.0f);
+					mastWeights[player].assign(length * length, weight);
+				}
+				scratch.resize(length * length);
+			}
+
+			moves.reserve(length * length);
+			_Patterns();
+			_Neighbours();
+		}
+
+
+		void Policy::SetMoves(const Board& board)
+		{
+			moves.clear();
+			for (int i = 0; i < board.Area(); ++i)
+			{
+				if (board.IsLegalMove(i))
+				{
+					index[i] = (int)moves.size();
+					moves.push_back(i);
+				}
+			}
+			remaining = (int)moves.size();
+			if (settings.mast) ResetWeights();
+		}
+
+
+		void Policy::Restart()
+		{
+			remaining = (int)moves.size();
+			if (settings.mast) ResetWeights();
+		}
+
+
+		int Policy::Next(const Board& board, int lastMove, Random& rng)
+		{
+			D(if (remaining == 0) throw std::logic_error("No moves left"));
+			if (settings.bridgeReply > 0.0f && lastMove >= 0)
+			{
+				int reply = BridgeReply(board, lastMove);
+				if (reply != -1 && (settings.bridgeReply >= 1.0f || rng.Uniform() < settings.bridgeReply))
+				{
+					return Take(index[reply]);
+				}
+			}
+
+			if (settings.lastGoodReply && lastMove >= 0)
+			{
+				int reply = LastGoodReply(board, lastMove);
+				if (reply != -1) return Take(index[reply]);
+			}
+
+			if (settings.mast)
+			{
+				const FenwickTree& tree = mastTrees[(board.WhiteToMove()) ? 0 : 1];
+				int cell = tree.Sample(rng);
+
+				//Rounding in the tree can leave a draw on a taken cell
+				if (tree.Weight(cell) > 0.0f) return Take(index[cell]);
+				return Take(rng.Bounded(remaining));
+			}
+
+			if (!settings.patterns) return Take(rng.Bounded(remaining));
+
+			const PatternTable& table = _Patterns();
+			const float* weights = table.weights[(board.WhiteToMove()) ? 0 : 1];
+			int i = rng.Bounded(remaining);
+			for (int tries = 1; tries < MAX_TRIES; ++tries)
+			{
+				if (rng.Uniform() * table.max < weights[Pattern(board, moves[i])]) break;
+				i = rng.Bounded(remaining);
+			}
+			return Take(i);
+		}
+
+
+		int Policy::Remaining() const
+		{
+			return remaining;
+		}
+
+
+		void Policy::Learn(bool white, const std::vector<int>& first, const std::vector<int>& second, WinState result)
+		{
+			if (!settings.lastGoodReply && !settings.mast) return;
+
+			int winner = (result == WinState::White) ? 0 : 1;
+			int player = (white) ? 0 : 1;
+			int last = -1;
+			for (const std::vector<int>* moves : { &first, &second })
+			{
+				for (int move : *moves)
+				{
+					if (settings.mast)
+					{
+						mastGames[player][move] += 1.0f;
+						if (player == winner) mastWins[player][move] += 1.0f;
+						mastWeights[player][move] = std::exp(MoveAverage(player == 0, move) / settings.mastTemperature);
+					}
+					if (settings.lastGoodReply && last != -1)
+					{
+						int& reply = replies[player][last];
+						if (player == winner) reply = move;
+						else if (reply == move) reply = -1;
+					}
+					last = move;
+					player = 1 - player;
+				}
+			}
+		}
+
+
+		void Policy::Clear()
+		{
+			for (int player = 0; player < 2; ++player)
+			{
+				std::fill(replies[player].begin(), replies[player].end(), -1);
+				std::fill(mastGames[player].begin(), mastGames[player].end(), 0.0f);
+				std::fill(mastWins[player].begin(), mastWins[player].end(), 0.0f);
+				std::fill(mastWeights[player].begin(), mastWeights[player].end(), std::exp(0.5f / settings.mastTemperature));
+			}
+			if (settings.mast) ResetWeights();
+		}
+
+
+		int Policy::LastGoodReply(const Board& board, int lastMove) const
+		{
+			int reply = replies[(board.WhiteToMove()) ? 0 : 1][lastMove];
+			return (reply != -1 && board[reply] == Hexagon::Unoccupied) ? reply : -1;
+		}
+
+
+		float Policy::MoveAverage(bool white, int cell) const
+		{
+			int player = (white) ? 0 : 1;
+			float games = mastGames[player][cell];
+			return (games > 0.0f) ? mastWins[player][cell] / games : 0.5f;
+		}
+
+
+		int Policy::Pattern(const Board& board, int cell)
+		{
+			const int* around = _Around(board, cell);
+			int pattern = 0;
+			for (int d = 0; d < 6; ++d)
+			{
+				pattern |= (int)Contents(board, around[d]) << (2 * d);
+			}
+			return pattern;
+		}
+
+
+		int Policy::BridgeReply(const Board& board, int lastMove)
+		{
+			const int* around = _Around(board, lastMove);
+			Hexagon own = (board.WhiteToMove()) ? Hexagon::White : Hexagon::Black;
+			for (int d = 0; d < 6; ++d)
+			{
+				int other = around[d];
+				if (other < 0 || board[other] != Hexagon::Unoccupied) continue;
+
+				//The cells either side of d border both lastMove and other
+				int before = around[(d + 5) % 6];
+				int after = around[(d + 1) % 6];
+				if (before < 0 && after < 0) continue;
+				if (Contents(board, before) == own && Contents(board, after) == own) return other;
+			}
+			return -1;
+		}
+
+
+		float Policy::Weight(int pattern, bool white)
+		{
+			return _Patterns().weights[(white) ? 0 : 1][pattern];
+		}
+
+
+		int Policy::Take(int i)
+		{
+			int move = moves[i];
+			--remaining;
+			moves[i] = moves[remaining];
+			index[moves[i]] = i;
+			moves[remaining] = move;
+			index[move] = remaining;
+			if (settings.mast)
+			{
+				mastTrees[0].Set(move, 0.0f);
+				mastTrees[1].Set(move, 0.0f);
+			}
+			return move;
+		}
+
+
+		void Policy::ResetWeights()
+		{
+			for (int player = 0; player < 2; ++player)
+			{
+				std::fill(scratch.begin(), scratch.end(), 0.0f);
+				for (int move : moves)
+				{
+					scratch[move] = mastWeights[player][move];
+				}
+				mastTrees[player].Assign(scratch.data(), (int)scratch.size());
+			}
+		}
+
+
+		Hexagon Policy::Contents(const Board& board, int neighbour)
+		{
+			return (neighbour >= 0) ? board[neighbour] : (Hexagon)(-neighbour);
+		}
+	}
+}
\ No newline at end of file
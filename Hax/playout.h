@@ -0,0 +1,161 @@
+/*
+ * Move selection for the random playouts of the search.
+ * 
+ * Uniformly random playouts are cheap but play badly: most obviously they
+ * let a player's two-bridges be cut, so a position that is won for either
+ * side often scores close to even. The policy here can add some cheap
+ * pieces of Hex knowledge, tried in this order:
+ * 
+ *   - Bridge replies. When the opponent plays into one of the two empty
+ *     cells between a pair of our stones (or a stone and our edge) that
+ *     share both as neighbours, we usually play the other.
+ * 
+ *   - Last good reply with forgetting. Each player remembers, for every
+ *     move of the opponent, the reply it made in the last playout it won
+ *     after that move, and plays it again while it is legal. A reply is
+ *     forgotten when a playout using it is lost.
+ * 
+ *   - Move-average sampling (MAST). Each player keeps the fraction of
+ *     playouts won after playing each cell, anywhere in the game, and draws
+ *     every other move with Gibbs weight exp(average / temperature). The
+ *     weights of the available cells are kept in a Fenwick tree per player,
+ *     so taking a move and drawing one both cost O(log area).
+ * 
+ *   - Pattern weights. Every other move is drawn with a weight that depends
+ *     only on the six cells around it, packed two bits per neighbour into a
+ *     12-bit index of a precomputed table. Draws use rejection sampling
+ *     against the table's largest weight, so no per-move totals are kept.
+ *     Ignored when MAST is on.
+ * 
+ * Cells off the board count as stones of the player owning that edge.
+ * With everything off every move is uniformly random, drawn exactly as
+ * the search always has.
+*/
+
+
+#pragma once
+#include <vector>
+#include "board.h"
+#include "fenwick.h"
+#include "random.h"
+#include "debug.h"
+
+
+namespace Hax
+{
+	namespace Playout
+	{
+		//Number of entries in the pattern tables (6 neighbours, 2 bits each).
+		const int PATTERNS = 1 << 12;
+
+
+		/*
+		 * bridgeReply: Probability of answering an intrusion into one of our
+		 *              two-bridges in its other cell. 0 disables the replies.
+		 * 
+		 * lastGoodReply: If true, replies that won earlier playouts are replayed.
+		 * 
+		 * patterns: If true, moves are weighted by their neighbourhood,
+		 *           otherwise they are uniformly random.
+		 * 
+		 * mast: If true, moves are weighted by how often they won earlier
+		 *       playouts, in place of the patterns.
+		 * 
+		 * mastTemperature: Gibbs temperature of the MAST weights. Lower values
+		 *                  favour the best moves more strongly.
+		*/
+		struct Settings
+		{
+			float bridgeReply = 0.0f;
+			bool lastGoodReply = false;
+			bool patterns = false;
+			bool mast = false;
+			float mastTemperature = 0.1f;
+		};
+
+
+		//Playout policy for one thread. Learnt replies and move averages are
+		//kept until Clear is called.
+		class Policy
+		{
+		public:
+			//length: Length of the boards to be played on.
+			Policy(int length, const Settings& settings);
+
+			//Sets the moves to choose from to the empty cells of board.
+			void SetMoves(const Board& board);
+
+			//Makes every move given by SetMoves available again, for another
+			//playout from the same position.
+			void Restart();
+
+			//Chooses a move for the player to move on board, given the move
+			//played just before it (-1 if unknown), and removes it from those
+			//available. Must only be called while moves remain.
+			int Next(const Board& board, int lastMove, Random& rng);
+
+			//Returns the number of moves still available.
+			int Remaining() const;
+
+			//Updates the reply tables and move averages from a finished game: moves, played
+			//alternately starting with white (if true), and its result.
+			//The moves may be given in two parts, such as the tree's and the
+			//playout's.
+			void Learn(bool white, const std::vector<int>& first, const std::vector<int>& second, WinState result);
+
+			//Forgets every learnt reply and move average.
+			void Clear();
+
+			//Returns the last good reply of the player to move on board to
+			//lastMove if it is legal, otherwise -1.
+			int LastGoodReply(const Board& board, int lastMove) const;
+
+			//Returns the fraction of learnt games won by the player who played
+			//cell, counting an unplayed cell as half won.
+			float MoveAverage(bool white, int cell) const;
+
+			//Returns the packed contents of the six neighbours of cell, two bits
+			//each, in the order of Hexagon with edges as their owner's stones.
+			static int Pattern(const Board& board, int cell);
+
+			//Returns the cell that restores a two-bridge of the player to move
+			//which lastMove intruded into, or -1 if there is none.
+			static int BridgeReply(const Board& board, int lastMove);
+
+			//Returns the weight of a move with the given neighbour pattern, for
+			//the given player.
+			static float Weight(int pattern, bool white);
+
+		private:
+			//Removes the available move at index from those available.
+			int Take(int index);
+
+			//Fills the MAST trees with the weights of the available moves.
+			void ResetWeights();
+
+			//Contents of a neighbour of a cell, which is the negated edge owner
+			//for cells off the board.
+			static Hexagon Contents(const Board& board, int neighbour);
+
+			Settings settings;
+
+			//replies[player][move] is the player's last good reply to move, or -1.
+			std::vector<int> replies[2];
+
+			//Per player and cell: games played, games won and Gibbs weight.
+			std::vector<float> mastGames[2];
+			std::vector<float> mastWins[2];
+			std::vector<float> mastWeights[2];
+
+			//Per player, the Gibbs weights of the available moves, 0 elsewhere.
+			FenwickTree mastTrees[2];
+			std::vector<float> scratch;
+
+			//Moves moves[0, remaining) are available. index[cell] is the
+			//position of cell in moves.
+			std::vector<int> moves;
+			std::vector<int> index;
+			int remaining;
+		};
+	}
+}
\ No newline at end of file
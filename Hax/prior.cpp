@@ -0,0 +1,151 @@
+#include <algorithm>
+#include "prior.h"
+#include "pathfinding.h"
+
+namespace Hax
+{
+	namespace Prior
+	{
+		//Bonus, relative to an ordinary pattern weight, for a move forming a
+		//two-bridge with one of our stones or edges.
+		const float BRIDGE_BONUS = 1.0f;
+
+		//Edge priors by distance from the nearest edge, beyond which all
+		//cells rate 1.
+		const float EDGE_PRIORS[] = { 0.25f, 0.6f };
+
+		//Far cell of a bridge that does not fit on the board.
+		const int NO_BRIDGE = -3;
+
+
+		Scorer::Scorer(int length, Kind kind) :
+			kind(kind), length(length), bridges(18 * length * length)
+		{
+			//Bridge offsets and their carriers, going round the cell in the
+			//order of the playout policy's directions.
+			const static int xIncs[] = { 1,  1,  0, -1, -1, 0 };
+			const static int yIncs[] = { 0, -1, -1,  0,  1, 1 };
+			for (int cell = 0; cell < length * length; ++cell)
+			{
+				int x = cell % length;
+				int y = cell / length;
+				for (int d = 0; d < 6; ++d)
+				{
+					int e = (d + 1) % 6;
+					int* bridge = &bridges[18 * cell + 3 * d];
+					int fx = x + xIncs[d] + xIncs[e];
+					int fy = y + yIncs[d] + yIncs[e];
+					bridge[1] = y + yIncs[d] >= 0 && y + yIncs[d] < length && x + xIncs[d] >= 0 && x + xIncs[d] < length ?
+						(y + yIncs[d]) * length + x + xIncs[d] : -1;
+					bridge[2] = y + yIncs[e] >= 0 && y + yIncs[e] < length && x + xIncs[e] >= 0 && x + xIncs[e] < length ?
+						(y + yIncs[e]) * length + x + xIncs[e] : -1;
+
+					if (fx >= 0 && fx < length && fy >= 0 && fy < length) bridge[0] = fy * length + fx;
+					else if ((fy == -1 || fy == length) && fx >= 0 && fx < length) bridge[0] = -(int)Hexagon::White;
+					else if ((fx == -1 || fx == length) && fy >= 0 && fy < length) bridge[0] = -(int)Hexagon::Black;
+					else bridge[0] = NO_BRIDGE;
+
+					//An edge bridge needs both carriers on the board
+					if (bridge[0] < 0 && (bridge[1] < 0 || bridge[2] < 0)) bridge[0] = NO_BRIDGE;
+				}
+			}
+
+			if (kind == Kind::Distance)
+			{
+				start.resize(2 * length * length);
+				end.resize(2 * length * length);
+			}
+		}
+
+
+		Kind Scorer::GetKind() const
+		{
+			return kind;
+		}
+
+
+		void Scorer::Score(const Board& board, int lastMove, const std::vector<int>& moves, std::vector<float>& priors)
+		{
+			D(if (board.Length() != length) throw std::invalid_argument("Board size does not match the scorer"));
+			priors.resize(moves.size());
+			std::fill(priors.begin(), priors.end(), 0.0f);
+			if (moves.empty()) return;
+
+			switch (kind)
+			{
+			case Kind::None:
+				return;
+
+			case Kind::Bridge:
+			{
+				int reply = (lastMove >= 0) ? Playout::Policy::BridgeReply(board, lastMove) : -1;
+				for (size_t i = 0; i < moves.size(); ++i)
+				{
+					priors[i] = BridgeScore(board, moves[i]);
+				}
+
+				float best = *std::max_element(priors.begin(), priors.end());
+				for (size_t i = 0; i < moves.size(); ++i)
+				{
+					priors[i] = (moves[i] == reply) ? 1.0f : priors[i] / best;
+				}
+				return;
+			}
+
+			case Kind::Distance:
+			{
+				int area = board.Area();
+				bool white = board.WhiteToMove();
+				lengths.resize(moves.size());
+				Pathfinding::EdgeDistances(board, white, start.data(), end.data());
+				Pathfinding::EdgeDistances(board, !white, start.data() + area, end.data() + area);
+
+				//Empty cells count in both directions, so remove one copy
+				int best = Pathfinding::UNREACHABLE;
+				for (size_t i = 0; i < moves.size(); ++i)
+				{
+					int move = moves[i];
+					int own = std::min(start[move] + end[move] - 1, Pathfinding::UNREACHABLE);
+					int opp = std::min(start[area + move] + end[area + move] - 1, Pathfinding::UNREACHABLE);
+					lengths[i] = std::min(own, opp);
+					best = std::min(best, lengths[i]);
+				}
+
+				for (size_t i = 0; i < moves.size(); ++i)
+				{
+					priors[i] = (lengths[i] < Pathfinding::UNREACHABLE) ? (float)best / lengths[i] : 0.0f;
+				}
+				return;
+			}
+
+			case Kind::Edge:
+				for (size_t i = 0; i < moves.size(); ++i)
+				{
+					int x = moves[i] % length;
+					int y = moves[i] / length;
+					int distance = std::min(std::min(x, length - 1 - x), std::min(y, length - 1 - y));
+					priors[i] = (distance < 2) ? EDGE_PRIORS[distance] : 1.0f;
+				}
+				return;
+			}
+		}
+
+
+		float Scorer::BridgeScore(const Board& board, int cell) const
+		{
+			bool white = board.WhiteToMove();
+			Hexagon own = (white) ? Hexagon::White : Hexagon::Black;
+			float score = Playout::Policy::Weight(Playout::Policy::Pattern(board, cell), white);
+			for (int d = 0; d < 6; ++d)
+			{
+				const int* bridge = &bridges[18 * cell + 3 * d];
+				bool ours = (bridge[0] >= 0) ? board[bridge[0]] == own : bridge[0] == -(int)own;
+				if (ours && board[bridge[1]] == Hexagon::Unoccupied && board[bridge[2]] == Hexagon::Unoccupied)
+				{
+					return score + BRIDGE_BONUS;
+				}
+			}
+			return score;
+		}
+	}
+}
\ No newline at end of file
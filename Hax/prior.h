@@ -0,0 +1,75 @@
+/*
+ * Cheap static estimates of how good each move is, used by the search to
+ * bias selection towards likely moves before their statistics mean much
+ * (progressive bias) and to decide which moves of a node to search first
+ * (progressive widening).
+ * 
+ * Each scorer rates every candidate move between 0 and 1, the best move
+ * of the position getting 1:
+ * 
+ *   - Bridge: the playout policy's neighbourhood pattern weight, plus a
+ *     bonus for forming a two-bridge with one of our stones or our edge.
+ *     Restoring a two-bridge the opponent just intruded into rates 1.
+ * 
+ *   - Distance: how short the shortest remaining connection through the
+ *     cell is, for whichever player's is shorter, so that cells on either
+ *     side's best path rate highly.
+ * 
+ *   - Edge: distance from the nearest edge, since cells on the first two
+ *     rows are rarely worth playing early.
+*/
+
+
+#pragma once
+#include <vector>
+#include "board.h"
+#include "playout.h"
+#include "debug.h"
+
+
+namespace Hax
+{
+	namespace Prior
+	{
+		enum class Kind
+		{
+			None,
+			Bridge,
+			Distance,
+			Edge
+		};
+
+
+		//Scores moves with one kind of prior, on boards of one size. Keeps
+		//working space, so use one scorer per thread.
+		class Scorer
+		{
+		public:
+			//length: Length of the boards to be scored.
+			Scorer(int length, Kind kind);
+
+			Kind GetKind() const;
+
+			//Writes the prior of each of moves, for the player to move on
+			//board, to priors. lastMove is the move played just before (-1 if
+			//unknown). Kind::None rates every move 0.
+			void Score(const Board& board, int lastMove, const std::vector<int>& moves, std::vector<float>& priors);
+
+		private:
+			float BridgeScore(const Board& board, int cell) const;
+
+			Kind kind;
+			int length;
+
+			//For each cell and direction, the cell a two-bridge away and the
+			//two cells carrying the bridge. The far cell is -(int)owner if it
+			//lies just beyond an edge, and less than that if it is off the board.
+			std::vector<int> bridges;
+			std::vector<int> start;
+			std::vector<int> end;
+
+			//Shortest connection through each of the moves being scored.
+			std::vector<int> lengths;
+		};
+	}
+}
\ No newline at end of file
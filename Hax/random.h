@@ -0,0 +1,118 @@
+/*
+ * Small, fast pseudo-random number generator for the search.
+ * 
+ * Implements xoshiro256++ (Blackman & Vigna), seeded through splitmix64.
+ * The whole state is 32 bytes so every search thread can own one cheaply.
+ * 
+ * Independent streams for parallel searches are split off with Jump(),
+ * which advances the generator by 2^128 draws, so streams taken from one
+ * seed never overlap.
+ * 
+ * Satisfies UniformRandomBitGenerator so it can be used with <random>,
+ * but Bounded() should be preferred in hot loops.
+*/
+
+
+#pragma once
+#include <cstdint>
+#include "debug.h"
+
+
+namespace Hax
+{
+	class Random
+	{
+	public:
+		using result_type = uint64_t;
+
+		Random(uint64_t seed)
+		{
+			Seed(seed);
+		}
+
+		//Resets the state from a single 64-bit seed.
+		void Seed(uint64_t seed)
+		{
+			for (uint64_t& word : s)
+			{
+				seed += 0x9e3779b97f4a7c15ULL;
+				uint64_t z = seed;
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+				word = z ^ (z >> 31);
+			}
+		}
+
+		//Returns the next 64 random bits.
+		uint64_t Next()
+		{
+			uint64_t result = Rotl(s[0] + s[3], 23) + s[0];
+			uint64_t t = s[1] << 17;
+			s[2] ^= s[0];
+			s[3] ^= s[1];
+			s[1] ^= s[2];
+			s[0] ^= s[3];
+			s[2] ^= t;
+			s[3] = Rotl(s[3], 45);
+			return result;
+		}
+
+		//Returns a uniformly distributed integer in [0, range).
+		//Uses Lemire's multiply-shift with rejection, so there is no modulo
+		//bias and usually no division.
+		uint32_t Bounded(uint32_t range)
+		{
+			D(if (range == 0) throw std::invalid_argument("range must be positive"));
+			uint64_t m = (Next() >> 32) * range;
+			uint32_t low = (uint32_t)m;
+			if (low < range)
+			{
+				uint32_t threshold = (0u - range) % range;
+				while (low < threshold)
+				{
+					m = (Next() >> 32) * range;
+					low = (uint32_t)m;
+				}
+			}
+			return (uint32_t)(m >> 32);
+		}
+
+		//Returns a uniformly distributed float in [0, 1).
+		float Uniform()
+		{
+			return (Next() >> 40) * (1.0f / 16777216.0f);
+		}
+
+		//Advances the generator by 2^128 draws. Call once per extra thread
+		//to give each thread its own non-overlapping stream.
+		void Jump()
+		{
+			static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+			uint64_t t[4] = { 0, 0, 0, 0 };
+			for (uint64_t jump : JUMP)
+			{
+				for (int b = 0; b < 64; ++b)
+				{
+					if (jump & (1ULL << b))
+					{
+						for (int i = 0; i < 4; ++i) t[i] ^= s[i];
+					}
+					Next();
+				}
+			}
+			for (int i = 0; i < 4; ++i) s[i] = t[i];
+		}
+
+		static constexpr uint64_t min() { return 0; }
+		static constexpr uint64_t max() { return UINT64_MAX; }
+		uint64_t operator()() { return Next(); }
+
+	private:
+		static uint64_t Rotl(uint64_t x, int k)
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+
+		uint64_t s[4];
+	};
+}
\ No newline at end of file
@@ -1,4 +1,12 @@
 #include "search.h"
+#include <limits>
+#include <cstddef>
+
+//Child selection scores four children at a time where SSE2 is available.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAX_SSE
+#include <emmintrin.h>
+#endif
 
 namespace Hax
 {
@@ -23,198 +31,1480 @@ namespace Hax
 		}
 
 
-		struct Node
+		int _ColorIndex(bool white)
+		{
+			return (white) ? 0 : 1;
+		}
+
+
+		int Children::Add(int move, uint64_t key, TTEntry* entry)
+		{
+			moves.push_back(move);
+			n.push_back(0.0f);
+			w.push_back(0.0f);
+			nr.push_back(0.0f);
+			wr.push_back(0.0f);
+			prior.push_back(0.0f);
+			proof.push_back(Proof::Unknown);
+			keys.push_back(key);
+			entries.push_back(entry);
+			return Size() - 1;
+		}
+
+
+		int Children::Size() const
+		{
+			return (int)moves.size();
+		}
+
+
+		//Returns true if the child's transposition entry still belongs to it.
+		bool _HasEntry(const Children& children, int slot)
+		{
+			return children.entries[slot] != nullptr && children.entries[slot]->key == children.keys[slot];
+		}
+
+
+		//Adds a slot for the child reached by playing move on board, with the
+		//given static prior, picking up any statistics the table already holds
+		//for the resulting position, and AMAF priors for move after context
+		//(-1 if unknown) from the shared AMAF table.
+		int _AddChild(Children& children, const Board& board, int move, float prior, int context,
+			TranspositionTable* table, const AmafTable* amaf, const Params& params)
+		{
+			uint64_t key = board.Hash() ^ ZobristKey((board.WhiteToMove()) ? Hexagon::White : Hexagon::Black, move);
+			int slot = children.Add(move, key, (table) ? table->Find(key) : nullptr);
+			children.prior[slot] = prior;
+			if (amaf)
+			{
+				float n, w;
+				amaf->Get(board.WhiteToMove(), (context < 0) ? amaf->NoContext() : context, move, n, w);
+				float scale = (n > params.amafPrior) ? params.amafPrior / n : 1.0f;
+				children.nr[slot] = n * scale;
+				children.wr[slot] = w * scale;
+			}
+			return slot;
+		}
+
+
+		//Preallocated storage for node records. Blocks are carved from chunks
+		//of NODE_CHUNK at a time and a released block goes back on the free
+		//list for the next record, so growing the tree seldom allocates.
+		//Memory is only returned when the pool is destroyed, and a pool must
+		//only be used by one thread at a time.
+		class NodePool
+		{
+		public:
+			//A node record and the reference counts make_shared stores with it.
+			static const size_t BLOCK_SIZE = sizeof(Node) + 64;
+			static const size_t NODE_CHUNK = 4096;
+
+			NodePool()
+			{
+				Grow();
+			}
+
+			void* Allocate(size_t size)
+			{
+				if (size > BLOCK_SIZE) return ::operator new(size);
+				if (free.empty()) Grow();
+				void* block = free.back();
+				free.pop_back();
+				return block;
+			}
+
+			void Deallocate(void* block, size_t size)
+			{
+				if (size > BLOCK_SIZE) ::operator delete(block);
+				else free.push_back(block);
+			}
+
+		private:
+			struct Block
+			{
+				alignas(std::max_align_t) unsigned char bytes[BLOCK_SIZE];
+			};
+
+			void Grow()
+			{
+				chunks.push_back(std::unique_ptr<Block[]>(new Block[NODE_CHUNK]));
+				free.reserve(chunks.size() * NODE_CHUNK);
+				for (size_t i = 0; i < NODE_CHUNK; ++i)
+				{
+					free.push_back(&chunks.back()[i]);
+				}
+			}
+
+			std::vector<std::unique_ptr<Block[]>> chunks;
+			std::vector<void*> free;
+		};
+
+
+		//Allocator handing out the blocks of a NodePool.
+		template<class T>
+		struct NodeAllocator
 		{
-			Node() : n(0.0f), nr(0.0f), w(0.0f), wr(0.0f) {}
-			float n;
-			float nr;
-			float w;
-			float wr;
+			using value_type = T;
+
+			NodeAllocator(NodePool* pool) : pool(pool) {}
+
+			template<class U>
+			NodeAllocator(const NodeAllocator<U>& other) : pool(other.pool) {}
+
+			T* allocate(size_t n)
+			{
+				return static_cast<T*>(pool->Allocate(n * sizeof(T)));
+			}
+
+			void deallocate(T* p, size_t n)
+			{
+				pool->Deallocate(p, n * sizeof(T));
+			}
+
+			NodePool* pool;
 		};
 
 
-		using GameTree = Tree<int, Node>;
+		template<class T, class U>
+		bool operator==(const NodeAllocator<T>& a, const NodeAllocator<U>& b)
+		{
+			return a.pool == b.pool;
+		}
 
 
-		void _MonteCarloSearch(GameTree& tree, Board board, long long maxTime, float expBias, float b)
+		template<class T, class U>
+		bool operator!=(const NodeAllocator<T>& a, const NodeAllocator<U>& b)
 		{
-			std::random_device rd;
-			std::mt19937 e{ rd() };
-			maxTime *= 1000;
-			long long elapsed = 0;
-			std::set<int> legalMoves;
+			return a.pool != b.pool;
+		}
+
+
+		//Returns the node record of the position with the given key, allocated
+		//from pool. With a table, a record another path to the position already
+		//created is shared, and a new one is registered for later paths to find.
+		NodePtr _FindNode(uint64_t key, TranspositionTable* table, NodePool& pool)
+		{
+			if (!table) return std::allocate_shared<Node>(NodeAllocator<Node>(&pool));
+
+			TTEntry* entry = table->Find(key);
+			NodePtr node = (entry) ? entry->node.lock() : nullptr;
+			if (!node)
+			{
+				node = std::allocate_shared<Node>(NodeAllocator<Node>(&pool));
+				if (!entry) entry = table->Insert(key);
+				entry->node = node;
+			}
+			return node;
+		}
+
+
+		//Records a playout in the shared AMAF table: every move from the root
+		//on, each in the context of the move before it.
+		void _RecordPlayout(AmafTable& amaf, bool white, const std::vector<int>& path, const std::vector<int>& playout, WinState result)
+		{
+			int context = amaf.NoContext();
+			for (const std::vector<int>* moves : { &path, &playout })
+			{
+				for (int move : *moves)
+				{
+					amaf.Update(white, context, move, (white) ? result == WinState::White : result == WinState::Black);
+					context = move;
+					white = !white;
+				}
+			}
+		}
+
+
+		//Selection score of one child. Unvisited children (only present in
+		//first-play urgency mode) take their AMAF value if they have one,
+		//otherwise the constant fpu.
+		float _Score(float n, float w, float nr, float wr, float N_i, const Params& params)
+		{
+			if (n > 0.0f) return _Ucb(w, n, wr, nr, N_i, params.expBias, params.b);
+			if (params.raveInit && nr > 0.0f) return wr / nr;
+			return params.fpu;
+		}
+
+
+#ifdef HAX_SSE
+		//Approximate reciprocal refined by one Newton-Raphson step, which is
+		//accurate to about 1e-7 relative and much cheaper than a division.
+		__m128 _Reciprocal(__m128 x)
+		{
+			__m128 r = _mm_rcp_ps(x);
+			return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(x, r)));
+		}
+
+
+		//Per-lane mask ? a : b.
+		__m128 _Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+#endif
+
+
+		//Writes the selection score of every child to scores, as _Score would,
+		//plus the progressive bias of its prior unless prior is null.
+		//log(N_i) is the same for every child so is only taken once, and
+		//children are scored four at a time where SSE is available.
+		void _ScoreAll(const float* n, const float* w, const float* nr, const float* wr, const float* prior,
+			int size, float N_i, const Params& params, float* scores)
+		{
+			int i = 0;
+#ifdef HAX_SSE
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 bias = _mm_set1_ps(params.expBias);
+			const __m128 bb = _mm_set1_ps(4.0f * params.b * params.b);
+			const __m128 logN = _mm_set1_ps(log(N_i));
+			const __m128 fpu = _mm_set1_ps(params.fpu);
+			const __m128 raveInit = (params.raveInit) ? _mm_cmpeq_ps(zero, zero) : zero;
+			const __m128 priorWeight = _mm_set1_ps(params.priorWeight);
+			for (; i + 4 <= size; i += 4)
+			{
+				__m128 vn = _mm_loadu_ps(n + i);
+				__m128 vw = _mm_loadu_ps(w + i);
+				__m128 vnr = _mm_loadu_ps(nr + i);
+				__m128 vwr = _mm_loadu_ps(wr + i);
+
+				//Counts are clamped to 1 so empty lanes divide safely; their
+				//wins are 0 and their results are replaced below anyway.
+				__m128 invN = _Reciprocal(_mm_max_ps(vn, one));
+				__m128 amaf = _mm_mul_ps(vwr, _Reciprocal(_mm_max_ps(vnr, one)));
+				__m128 denom = _mm_add_ps(_mm_add_ps(vn, vnr), _mm_mul_ps(bb, _mm_mul_ps(vn, vnr)));
+				__m128 beta = _mm_mul_ps(vnr, _Reciprocal(_mm_max_ps(denom, one)));
+
+				__m128 mc = _mm_mul_ps(_mm_sub_ps(one, beta), _mm_mul_ps(vw, invN));
+				mc = _mm_add_ps(mc, _mm_mul_ps(bias, _mm_sqrt_ps(_mm_mul_ps(logN, invN))));
+				__m128 ucb = _mm_add_ps(mc, _mm_mul_ps(beta, amaf));
+
+				__m128 unvisited = _Select(_mm_and_ps(raveInit, _mm_cmpgt_ps(vnr, zero)), amaf, fpu);
+				__m128 score = _Select(_mm_cmpgt_ps(vn, zero), ucb, unvisited);
+				if (prior)
+				{
+					__m128 bias = _mm_mul_ps(priorWeight, _mm_loadu_ps(prior + i));
+					score = _mm_add_ps(score, _mm_mul_ps(bias, _Reciprocal(_mm_add_ps(vn, one))));
+				}
+				_mm_storeu_ps(scores + i, score);
+			}
+#endif
+			for (; i < size; ++i)
+			{
+				scores[i] = _Score(n[i], w[i], nr[i], wr[i], N_i, params);
+				if (prior) scores[i] += params.priorWeight * prior[i] / (n[i] + 1.0f);
+			}
+		}
+
+
+		//Returns the index of the first highest score, or -1 if every score is
+		//minus infinity.
+		int _ArgMax(const float* scores, int size)
+		{
+			float best = -std::numeric_limits<float>::infinity();
+			int i = 0;
+#ifdef HAX_SSE
+			__m128 vbest = _mm_set1_ps(best);
+			for (; i + 4 <= size; i += 4)
+			{
+				vbest = _mm_max_ps(vbest, _mm_loadu_ps(scores + i));
+			}
+			vbest = _mm_max_ps(vbest, _mm_shuffle_ps(vbest, vbest, _MM_SHUFFLE(1, 0, 3, 2)));
+			vbest = _mm_max_ps(vbest, _mm_shuffle_ps(vbest, vbest, _MM_SHUFFLE(2, 3, 0, 1)));
+			best = _mm_cvtss_f32(vbest);
+#endif
+			for (; i < size; ++i)
+			{
+				best = std::max(best, scores[i]);
+			}
+
+			if (best == -std::numeric_limits<float>::infinity()) return -1;
+			for (i = 0; scores[i] != best; ++i);
+			return i;
+		}
+
+
+		//Returns true if the search orders and widens children by prior.
+		bool _Widening(const Params& params)
+		{
+			return params.prior != Prior::Kind::None && params.widening > 0;
+		}
+
+
+		//Returns how many of the node's children progressive widening lets
+		//selection choose from, which may exceed the number it has.
+		int _Width(const Node& node, const Params& params)
+		{
+			float growth = log(std::max(node.n, 1.0f)) / log(std::max(params.wideningGrowth, 1.01f));
+			return params.widening + (int)growth + node.children.proven;
+		}
+
+
+		//Returns the slot of the child to descend to, or -1 if every child is
+		//proven. With useTable, visit and win counts come from a child's
+		//transposition entry when it has one, so every path to a position sees
+		//the same statistics. The root does without, since only its slots hold
+		//the statistics imported from other threads (see _PublishRoot).
+		//With progressive widening only the first _Width children are offered.
+		//scratch is working space, resized as needed.
+		int _SelectChild(const Node& node, const Params& params, bool useTable, std::vector<float>& scratch)
+		{
+			const Children& children = node.children;
+			int size = children.Size();
+			if (_Widening(params)) size = std::min(size, _Width(node, params));
+			scratch.resize(3 * size);
+			float* scores = scratch.data();
+			const float* n = children.n.data();
+			const float* w = children.w.data();
+
+			if (useTable)
+			{
+				float* tn = scores + size;
+				float* tw = tn + size;
+				for (int i = 0; i < size; ++i)
+				{
+					bool live = _HasEntry(children, i);
+					tn[i] = (live) ? children.entries[i]->n : n[i];
+					tw[i] = (live) ? children.entries[i]->w : w[i];
+				}
+				n = tn;
+				w = tw;
+			}
+
+			//A visited child implies at least one visit here, except through a
+			//transposition, so keep the log defined.
+			float N_i = std::max(node.n, 1.0f);
+			bool bias = params.prior != Prior::Kind::None && params.priorWeight != 0.0f;
+			_ScoreAll(n, w, children.nr.data(), children.wr.data(), (bias) ? children.prior.data() : nullptr,
+				size, N_i, params, scores);
+			if (children.proven > 0)
+			{
+				for (int i = 0; i < size; ++i)
+				{
+					if (children.proof[i] != Proof::Unknown) scores[i] = -std::numeric_limits<float>::infinity();
+				}
+			}
+
+			return _ArgMax(scores, size);
+		}
+
+
+		//Returns true if the node has a child for every legal move and all of
+		//them are proven losses for the player making the move.
+		bool _AllRepliesLose(const Node& node, const Params& params)
+		{
+			const Children& children = node.children;
+			bool expanded = (params.firstPlayUrgency) ? children.Size() > 0 : node.initialised && node.untried.empty();
+			if (!expanded || children.proven < children.Size()) return false;
+
+			for (Proof proof : children.proof)
+			{
+				if (proof != Proof::Loss) return false;
+			}
+			return true;
+		}
+
+
+		//Target spacing between clock reads in the search loop. Bounds how far
+		//past the deadline a search can run.
+		const std::chrono::microseconds CHECK_INTERVAL(500);
+
+
+		//Deadline shared by all search threads. The clock is only read every
+		//few calls to Expired, with the spacing adjusted so reads happen about
+		//CHECK_INTERVAL apart whatever the cost of an iteration.
+		class DeadlineCheck
+		{
+		public:
+			DeadlineCheck(Clock::time_point deadline) : deadline(deadline), last(Clock::now()), every(1), count(0) {}
+
+			bool Expired()
+			{
+				if (++count < every) return false;
+				count = 0;
+
+				Clock::time_point now = Clock::now();
+				if (now >= deadline) return true;
+				if (now - last < CHECK_INTERVAL / 2) every *= 2;
+				else if (now - last > CHECK_INTERVAL && every > 1) every /= 2;
+				last = now;
+				return false;
+			}
+
+			//Returns true if the last call to Expired read the clock.
+			bool Sampled() const
+			{
+				return count == 0;
+			}
+
+			//Returns the time the clock was last read.
+			Clock::time_point LastSample() const
+			{
+				return last;
+			}
+
+		private:
+			Clock::time_point deadline;
+			Clock::time_point last;
+			int every;
+			int count;
+		};
+
+
+		//Spacing between samples of the root statistics by the search monitor.
+		const std::chrono::milliseconds MONITOR_INTERVAL(1);
+
+
+		//Statistics of one root child, or in the last entry of a row, the root.
+		struct RootStats
+		{
+			float n = 0.0f;
+			float w = 0.0f;
+			float nr = 0.0f;
+			float wr = 0.0f;
+		};
+
+
+		Playout::Settings _PolicySettings(const Params& params)
+		{
+			Playout::Settings settings;
+			settings.bridgeReply = params.bridgeReply;
+			settings.lastGoodReply = params.lastGoodReply;
+			settings.patterns = params.patterns;
+			settings.mast = params.mast;
+			settings.mastTemperature = params.mastTemperature;
+			return settings;
+		}
+
+
+		//Working space of one search thread, kept by the Searcher from one
+		//search to the next on boards of one size.
+		struct Workspace
+		{
+			Workspace(int length, const Params& params, NodePool& pool) :
+				imported(length * length + 1), published(length * length + 1), policy(length, _PolicySettings(params)), scorer(length, params.prior), pool(pool)
+			{
+				int area = length * length;
+				legalMoves.reserve(area);
+				path.reserve(area);
+				slots.reserve(area);
+				moveHist.reserve(area);
+				for (int c = 0; c < 2; ++c)
+				{
+					amafN[c].resize(area);
+					amafW[c].resize(area);
+				}
+			}
+
+			std::vector<int> legalMoves;
+			//Moves from the root to the current node, and the slot of each
+			//among its parent's children.
+			std::vector<int> path;
+			std::vector<int> slots;
+			std::vector<int> moveHist;
+			std::vector<float> scratch;
+			std::vector<float> priors;
+
+			//AMAF counts: for each cell, the playouts in which White (index 0) or
+			//Black (index 1) played it after the node currently being backed up,
+			//and how many of them that player won.
+			std::vector<float> amafN[2];
+			std::vector<float> amafW[2];
+
+			//Statistics of other threads merged into the root children.
+			std::vector<RootStats> imported;
+
+			//Statistics of the thread's own playouts at the root children, as
+			//last published to the other threads (see SearchControl).
+			std::vector<RootStats> published;
+
+			Playout::Policy policy;
+			Prior::Scorer scorer;
+
+			//Storage of the thread's node records, owned by the Searcher since
+			//the records may outlive the workspace.
+			NodePool& pool;
+		};
+
+
+		//State shared by the threads of a single search.
+		//
+		//Each worker publishes the statistics its own playouts gave its root
+		//children to its workspace's published row whenever it reads the clock,
+		//so the monitor can decide whether the search is settled without
+		//touching the trees themselves, and so workers can pull in each other's
+		//results when synchronising (see Params::syncInterval).
+		struct SearchControl
+		{
+			SearchControl(Clock::time_point deadline, const std::atomic<bool>& stop, const std::vector<std::unique_ptr<Workspace>>& workspaces) :
+				deadline(deadline), stop(stop), settled(false), solved(false), shareProofs(true), active((int)workspaces.size()),
+				playouts(0), nodes(0), workspaces(workspaces)
+			{
+				for (const std::unique_ptr<Workspace>& workspace : workspaces)
+				{
+					std::fill(workspace->published.begin(), workspace->published.end(), RootStats());
+				}
+			}
+
+			bool Stopped() const
+			{
+				return stop.load(std::memory_order_relaxed) || settled.load(std::memory_order_relaxed) ||
+					solved.load(std::memory_order_relaxed);
+			}
+
+			Clock::time_point deadline;
+			const std::atomic<bool>& stop;
+			std::atomic<bool> settled;
+
+			//Set once any thread has solved its root, which ends every thread's
+			//search if shareProofs is set. Without it, as under a playout or
+			//node budget, each thread runs on to its own limits so the result
+			//does not depend on which thread finished its proof first.
+			std::atomic<bool> solved;
+			bool shareProofs;
+			std::atomic<int> active;
+			std::atomic<long long> playouts;
+			std::atomic<long long> nodes;
+
+			//Guards the published rows of the workspaces, whose entry [move] is
+			//the statistics of that root child and entry [area] those of the
+			//root itself.
+			std::mutex mtx;
+			const std::vector<std::unique_ptr<Workspace>>& workspaces;
+		};
+
+
+		//Publishes the statistics of the tree's root children, less those
+		//imported from other threads. Then, if sync is set, replaces them with
+		//the totals over all threads, and records the other threads' part in
+		//imported. Children not yet expanded in this tree pick up their share
+		//at the first sync after they are.
+		void _PublishRoot(GameTree& tree, SearchControl& control, std::vector<RootStats>& imported, bool sync, int thread)
+		{
+			Node& root = *tree.Data();
+			Children& children = root.children;
+			std::lock_guard<std::mutex> lk(control.mtx);
+			std::vector<RootStats>& row = control.workspaces[thread]->published;
+			std::fill(row.begin(), row.end(), RootStats());
+			for (int i = 0; i < children.Size(); ++i)
+			{
+				RootStats& own = row[children.moves[i]];
+				const RootStats& other = imported[children.moves[i]];
+				own.n = children.n[i] - other.n;
+				own.w = children.w[i] - other.w;
+				own.nr = children.nr[i] - other.nr;
+				own.wr = children.wr[i] - other.wr;
+			}
+			row.back().n = root.n - imported.back().n;
+			if (!sync) return;
+
+			std::fill(imported.begin(), imported.end(), RootStats());
+			for (int t = 0; t < (int)control.workspaces.size(); ++t)
+			{
+				if (t == thread) continue;
+				for (int i = 0; i < children.Size(); ++i)
+				{
+					const RootStats& other = control.workspaces[t]->published[children.moves[i]];
+					RootStats& total = imported[children.moves[i]];
+					total.n += other.n;
+					total.w += other.w;
+					total.nr += other.nr;
+					total.wr += other.wr;
+				}
+				imported.back().n += control.workspaces[t]->published.back().n;
+			}
+
+			for (int i = 0; i < children.Size(); ++i)
+			{
+				const RootStats& own = row[children.moves[i]];
+				const RootStats& other = imported[children.moves[i]];
+				children.n[i] = own.n + other.n;
+				children.w[i] = own.w + other.w;
+				children.nr[i] = own.nr + other.nr;
+				children.wr[i] = own.wr + other.wr;
+			}
+			root.n = row.back().n + imported.back().n;
+		}
+
+
+		//Removes statistics imported by _PublishRoot, leaving the tree with
+		//only the results of its own playouts.
+		void _RemoveImported(GameTree& tree, const std::vector<RootStats>& imported)
+		{
+			Node& root = *tree.Data();
+			Children& children = root.children;
+			for (int i = 0; i < children.Size(); ++i)
+			{
+				const RootStats& other = imported[children.moves[i]];
+				children.n[i] -= other.n;
+				children.w[i] -= other.w;
+				children.nr[i] -= other.nr;
+				children.wr[i] -= other.wr;
+			}
+			root.n -= imported.back().n;
+		}
+
+
+		//Samples the published root statistics until the search finishes,
+		//and sets control.settled once the most visited root move leads the
+		//runner-up by more visits than the search can still add before the
+		//deadline, since the most visited move can then no longer change. Only
+		//valid when that is how the move is chosen (Decision::MaxVisits).
+		void _MonitorSearch(SearchControl& control, int area)
+		{
+			bool canSettle = control.deadline != Clock::time_point::max();
+			Clock::time_point start = Clock::now();
+			float startPlayouts = -1.0f;
+			std::vector<float> totals(area + 1);
+
+			while (control.active > 0 && !control.Stopped())
+			{
+				Clock::time_point now = Clock::now();
+				if (now >= control.deadline) return;
+				std::this_thread::sleep_until(std::min(now + MONITOR_INTERVAL, control.deadline));
+				if (!canSettle) continue;
+
+				std::fill(totals.begin(), totals.end(), 0.0f);
+				{
+					std::lock_guard<std::mutex> lk(control.mtx);
+					for (const std::unique_ptr<Workspace>& workspace : control.workspaces)
+					{
+						for (int i = 0; i <= area; ++i) totals[i] += workspace->published[i].n;
+					}
+				}
+
+				now = Clock::now();
+				if (startPlayouts < 0.0f)
+				{
+					start = now;
+					startPlayouts = totals[area];
+					continue;
+				}
+
+				float best = 0.0f;
+				float second = 0.0f;
+				for (int i = 0; i < area; ++i)
+				{
+					if (totals[i] > best)
+					{
+						second = best;
+						best = totals[i];
+					}
+
+					else if (totals[i] > second)
+					{
+						second = totals[i];
+					}
+				}
+
+				//Published statistics can lag by up to CHECK_INTERVAL, so count
+				//that as time still to run.
+				float elapsed = std::chrono::duration<float>(now - start).count();
+				float remaining = std::chrono::duration<float>(control.deadline - now + CHECK_INTERVAL).count();
+				float rate = (elapsed > 0.0f) ? (totals[area] - startPlayouts) / elapsed : 0.0f;
+				if (rate > 0.0f && best - second > rate * remaining)
+				{
+					control.settled = true;
+				}
+			}
+		}
+
+
+		//Overwrites moves with the board's legal moves.
+		void _LegalMoves(const Board& board, std::vector<int>& moves)
+		{
+			moves.clear();
 			for (int i = 0; i < board.Area(); ++i)
 			{
 				if (board.IsLegalMove(i))
 				{
-					legalMoves.insert(i);
+					moves.push_back(i);
 				}
 			}
-			std::set<int> moveHist;
-			while (elapsed < maxTime)
+		}
+
+
+		//If board is unchanged by a half turn, which maps cell i to
+		//area - 1 - i and each player's edges to each other, removes from moves
+		//the higher-numbered cell of each pair of moves mapped to one another.
+		//Both lead to equivalent positions, and the one kept is itself a legal
+		//move of the original board, so no answer needs mapping back.
+		void _PruneSymmetric(const Board& board, std::vector<int>& moves)
+		{
+			const int last = board.Area() - 1;
+			for (int i = 0; i < last - i; ++i)
 			{
+				if (board[i] != board[last - i]) return;
+			}
+			moves.erase(std::remove_if(moves.begin(), moves.end(), [last](int move) { return move > last - move; }), moves.end());
+		}
+
+
+		//Playout moves between checks of whether a truncated playout's position
+		//is already decided (see Params::truncateMargin).
+		const int TRUNCATE_INTERVAL = 4;
+
+
+		//Static evaluation of a position from its connection distances: the
+		//chance that White wins, by a logistic function of how many fewer
+		//cells White needs than Black, counting the player to move as half a
+		//cell ahead. margin is set to the absolute difference in cells.
+		float _Evaluate(const Board& board, const Params& params, int& margin)
+		{
+			int white = Pathfinding::ConnectionDistance(board, true);
+			int black = Pathfinding::ConnectionDistance(board, false);
+			margin = std::abs(black - white);
+			float lead = (float)std::max(std::min(black - white, board.Area()), -board.Area());
+			lead += (board.WhiteToMove()) ? 0.5f : -0.5f;
+			return 1.0f / (1.0f + exp(-params.truncateScale * lead));
+		}
+
+
+		//Sorts moves, and priors alongside them, into ascending order of prior.
+		void _SortByPrior(std::vector<int>& moves, std::vector<float>& priors)
+		{
+			std::vector<std::pair<float, int>> order(moves.size());
+			for (size_t i = 0; i < moves.size(); ++i)
+			{
+				order[i] = std::make_pair(priors[i], moves[i]);
+			}
+
+			std::sort(order.begin(), order.end());
+			for (size_t i = 0; i < moves.size(); ++i)
+			{
+				priors[i] = order[i].first;
+				moves[i] = order[i].second;
+			}
+		}
+
+
+		//Runs one thread's search until control says stop, or until maxPlayouts
+		//playouts have been made or maxNodes nodes added (zero means no limit).
+		//A solved root ends this thread's search, and the others' too unless
+		//control says the threads must finish independently.
+		void _MonteCarloSearch(GameTree& tree, Board board, SearchControl& control, const Params& params, Random& rng,
+			TranspositionTable* table, AmafTable* amaf, Workspace& workspace, long long maxPlayouts, long long maxNodes, int thread)
+		{
+			const bool rootWhite = board.WhiteToMove();
+			long long playouts = 0;
+			long long nodes = 0;
+			DeadlineCheck timer(control.deadline);
+			std::vector<int>& legalMoves = workspace.legalMoves;
+			std::vector<int>& path = workspace.path;
+			std::vector<int>& slots = workspace.slots;
+			std::vector<int>& moveHist = workspace.moveHist;
+			std::vector<float>& scratch = workspace.scratch;
+			std::vector<float>& priors = workspace.priors;
+			std::vector<float>* amafN = workspace.amafN;
+			std::vector<float>* amafW = workspace.amafW;
+			std::vector<RootStats>& imported = workspace.imported;
+			Playout::Policy& policy = workspace.policy;
+			Prior::Scorer& scorer = workspace.scorer;
+			NodePool& pool = workspace.pool;
+			const bool usePrior = params.prior != Prior::Kind::None;
+			const int leafPlayouts = std::max(params.leafPlayouts, 1);
+			std::fill(imported.begin(), imported.end(), RootStats());
+			Clock::time_point nextSync = Clock::now() + std::chrono::milliseconds(params.syncInterval);
+			while ((maxPlayouts == 0 || playouts < maxPlayouts) &&
+				   (maxNodes == 0 || nodes < maxNodes) &&
+				   tree.Data()->proof == Proof::Unknown &&
+				   !control.Stopped() && !timer.Expired())
+			{
+				if (timer.Sampled())
+				{
+					bool sync = params.syncInterval > 0 && timer.LastSample() >= nextSync;
+					if (sync) nextSync = timer.LastSample() + std::chrono::milliseconds(params.syncInterval);
+					_PublishRoot(tree, control, imported, sync, thread);
+				}
+
 				D(Board cpy(board));
-				D(if (legalMoves.size() != board.CountUnoccupied()) throw std::logic_error("missing legal moves"));
-				auto start = std::chrono::high_resolution_clock::now();
-				bool hasUnvisited = false;
-				while (legalMoves.size() > 0 && !hasUnvisited)
-				{
-					float best = -999.0f;
-					int bestMove = -1;
-					for (int i : legalMoves)
+				if (params.firstPlayUrgency)
+				{
+					//Slots for every legal move are added the second time a node is
+					//reached, so descent continues past nodes with unvisited moves
+					//and only stops on a child that has never been played out.
+					while (board.CountUnoccupied() > 0)
 					{
-						if (!tree.HasChild(i))
+						Node& data = *tree.Data();
+						if (data.children.Size() == 0)
 						{
-							hasUnvisited = true;
-							break;
-						}
+							int context = (path.empty()) ? -1 : path.back();
+							_LegalMoves(board, legalMoves);
+							if ((int)path.size() < params.symmetryDepth) _PruneSymmetric(board, legalMoves);
+							scorer.Score(board, context, legalMoves, priors);
 
-						Node& node = tree.Child(i);
-						float ucb = _Ucb(node.w, node.n, node.wr, node.nr, tree.Data().n, expBias, b);
-						if (ucb > best)
-						{
-							best = ucb;
-							bestMove = i;
+							//Best first, so widening offers the best moves
+							if (usePrior) _SortByPrior(legalMoves, priors);
+							for (int j = (int)legalMoves.size() - 1; j >= 0; --j)
+							{
+								_AddChild(data.children, board, legalMoves[j], priors[j], context, table, amaf, params);
+							}
+							nodes += legalMoves.size();
 						}
-					}
 
-					if (!hasUnvisited)
-					{
-						tree.Descend(bestMove);
-						board.MakeMove(bestMove);
-						legalMoves.erase(bestMove);
-						moveHist.insert(bestMove);
+						int slot = _SelectChild(data, params, table != nullptr && !tree.IsRoot(), scratch);
+						if (slot == -1) break;
+						int move = data.children.moves[slot];
+						bool unvisited = data.children.n[slot] == 0.0f;
+						if (!tree.HasChild(move)) tree.Insert(move, _FindNode(data.children.keys[slot], table, pool));
+						tree.Descend(move);
+						board.MakeMove(move);
+						path.push_back(move);
+						slots.push_back(slot);
+						if (unvisited || tree.Data()->proof != Proof::Unknown) break;
 					}
 				}
 
-				std::vector<int> unvisited(legalMoves.size(), -1);
-				size_t idxMax = 0;
-				for (int i : legalMoves)
+				else
 				{
-					if (!tree.HasChild(i))
+					//Descend through nodes with nothing left to expand, then pop
+					//the next untried move off the first node that still has one.
+					while (board.CountUnoccupied() > 0)
 					{
-						unvisited[idxMax++] = i;
+						Node& data = *tree.Data();
+						int context = (path.empty()) ? -1 : path.back();
+						if (!data.initialised)
+						{
+							_LegalMoves(board, data.untried);
+							if ((int)path.size() < params.symmetryDepth) _PruneSymmetric(board, data.untried);
+							if (usePrior)
+							{
+								scorer.Score(board, context, data.untried, data.priors);
+								_SortByPrior(data.untried, data.priors);
+							}
+							data.initialised = true;
+						}
+
+						bool widen = !_Widening(params) || data.children.Size() < _Width(data, params);
+						if (!data.untried.empty() && widen)
+						{
+							//Pop a random element, which keeps the expansion order shuffled
+							//without shuffling the whole stack up front. With priors the
+							//best remaining move is already at the back.
+							float prior = 0.0f;
+							if (usePrior)
+							{
+								prior = data.priors.back();
+								data.priors.pop_back();
+							}
+							else
+							{
+								std::swap(data.untried[rng.Bounded((uint32_t)data.untried.size())], data.untried.back());
+							}
+
+							int nextMove = data.untried.back();
+							data.untried.pop_back();
+							if (data.untried.empty())
+							{
+								std::vector<int>().swap(data.untried);
+								std::vector<float>().swap(data.priors);
+							}
+							int slot = _AddChild(data.children, board, nextMove, prior, context, table, amaf, params);
+							slots.push_back(slot);
+							tree.Insert(nextMove, _FindNode(data.children.keys[slot], table, pool));
+							++nodes;
+							tree.Descend(nextMove);
+							D(if (!board.IsLegalMove(nextMove)) throw std::logic_error("Overwriting board state"));
+							board.MakeMove(nextMove);
+							path.push_back(nextMove);
+							break;
+						}
+
+						int slot = _SelectChild(data, params, table != nullptr && !tree.IsRoot(), scratch);
+						if (slot == -1) break;
+						int move = data.children.moves[slot];
+						if (!tree.HasChild(move)) tree.Insert(move, _FindNode(data.children.keys[slot], table, pool));
+						tree.Descend(move);
+						board.MakeMove(move);
+						path.push_back(move);
+						slots.push_back(slot);
+
+						//A record shared with another path may have been proven
+						//there, which the backup passes on to this slot.
+						if (tree.Data()->proof != Proof::Unknown) break;
 					}
 				}
 
-				std::uniform_int_distribution<size_t> dist{ 0,  idxMax - 1 };
-				if (unvisited.size() > 0)
+				policy.SetMoves(board);
+				bool whiteToMove = board.WhiteToMove();
+				for (int c = 0; c < 2; ++c)
 				{
-					int nextMove = unvisited[dist(e)];
-					Node newNode;
-					tree.Insert(nextMove, std::move(newNode));
-					tree.Descend(nextMove);
-					D(if (!board.IsLegalMove(nextMove)) throw std::logic_error("Overwriting board state"));
-					board.MakeMove(nextMove);
-					legalMoves.erase(nextMove);
-					moveHist.insert(nextMove);
+					std::fill(amafN[c].begin(), amafN[c].end(), 0.0f);
+					std::fill(amafW[c].begin(), amafW[c].end(), 0.0f);
 				}
 
-				std::vector<int> moveOrder(legalMoves.begin(), legalMoves.end());
-				std::shuffle(moveOrder.begin(), moveOrder.end(), e);
-				size_t idx = 0;
-				bool whiteToMove = board.WhiteToMove();
-				WinState wState;
-
-				while ((wState = Pathfinding::CheckWinState(board, true)) == WinState::Ongoing)
+				//A real (not virtual) connection straight after entering a node
+				//proves it won for the player who just moved.
+				WinState wState = Pathfinding::CheckWinState(board, true);
+				if (params.solver && wState != WinState::Ongoing && !tree.IsRoot() &&
+					Pathfinding::CheckWinState(board) != WinState::Ongoing)
 				{
-					D(if (idx == moveOrder.size()) throw std::logic_error("Impossible state. All legal moves exhausted and no winner"));
-					int next = moveOrder[idx++];
-					board.MakeMove(next);
-					moveHist.insert(next);
-					legalMoves.erase(next);
+					tree.Data()->proof = Proof::Win;
 				}
 
-				bool isWinForNode = ((whiteToMove && wState == WinState::Black) || (!whiteToMove && wState == WinState::White));
-				
-				while (!tree.IsRoot())
+				//Playouts won by White (index 0) and Black (index 1).
+				float wins[2] = { 0.0f, 0.0f };
+				for (int k = 0; k < leafPlayouts; ++k)
 				{
-					Node& node = tree.Data();
-					node.n += 1.0f;
-					if (isWinForNode) node.w += 1.0f;
-
-					tree.Ascend();
-					for (int i : moveHist)
+					policy.Restart();
+					int last = (path.empty()) ? -1 : path.back();
+					WinState result = wState;
+					//White's chance of winning, if the playout was cut short.
+					float whiteWins = -1.0f;
+					while (result == WinState::Ongoing)
 					{
-						if ((!whiteToMove && board[i] == Hexagon::White) || (whiteToMove && board[i] == Hexagon::Black))
+						D(if (policy.Remaining() == 0) throw std::logic_error("Impossible state. All legal moves exhausted and no winner"));
+						int played = (int)moveHist.size();
+						bool cutoff = params.truncateMoves > 0 && played >= params.truncateMoves;
+						if (cutoff || (params.truncateMargin > 0 && played > 0 && played % TRUNCATE_INTERVAL == 0))
 						{
-							if (tree.HasChild(i))
+							int margin;
+							float chance = _Evaluate(board, params, margin);
+							if (cutoff || margin >= params.truncateMargin)
 							{
-								Node& child = tree.Child(i);
-								child.nr += 1.0f;
-								if (isWinForNode) child.wr += 1.0f;
+								whiteWins = chance;
+								result = (chance >= 0.5f) ? WinState::White : WinState::Black;
+								break;
 							}
 						}
+
+						last = policy.Next(board, last, rng);
+						board.MakeMove(last);
+						moveHist.push_back(last);
+						result = Pathfinding::CheckWinState(board, true);
+					}
+
+					//Share of the playout won by White (index 0) and Black (index 1).
+					if (whiteWins < 0.0f) whiteWins = (result == WinState::White) ? 1.0f : 0.0f;
+					const float share[2] = { whiteWins, 1.0f - whiteWins };
+					wins[0] += share[0];
+					wins[1] += share[1];
+					bool white = whiteToMove;
+					for (int move : moveHist)
+					{
+						int c = _ColorIndex(white);
+						amafN[c][move] += 1.0f;
+						amafW[c][move] += share[c];
+						white = !white;
+					}
+
+					if (amaf) _RecordPlayout(*amaf, rootWhite, path, moveHist, result);
+					policy.Learn(rootWhite, path, moveHist, result);
+					for (int i : moveHist)
+					{
+						board.UndoMove(i);
+					}
+					moveHist.clear();
+				}
+
+				//Walk back up the path, crediting each parent's children with the
+				//playouts in which their move was played later by the same player.
+				//The move leading out of a parent is added to the counts before
+				//visiting it, since it too was played after the parent.
+				float k = (float)leafPlayouts;
+				size_t depth = path.size();
+				while (!tree.IsRoot())
+				{
+					//The player who moved into the current node, and how often they won.
+					int mover = _ColorIndex(!whiteToMove);
+					float won = wins[mover];
+					tree.Data()->n += k;
+					Proof proof = tree.Data()->proof;
+					int move = path[--depth];
+					amafN[mover][move] += k;
+					amafW[mover][move] += won;
+					tree.Ascend();
+
+					Node& parent = *tree.Data();
+					Children& children = parent.children;
+					int slot = slots[depth];
+					children.n[slot] += k;
+					children.w[slot] += won;
+					if (table)
+					{
+						if (!_HasEntry(children, slot)) children.entries[slot] = table->Insert(children.keys[slot]);
+						children.entries[slot]->n += k;
+						children.entries[slot]->w += won;
+					}
+
+					//Minimax over proofs: one winning reply loses the parent, and
+					//the parent wins once every reply is known to lose.
+					if (proof != children.proof[slot])
+					{
+						children.proof[slot] = proof;
+						++children.proven;
+					}
+					if (proof == Proof::Win) parent.proof = Proof::Loss;
+					else if (proof == Proof::Loss && _AllRepliesLose(parent, params)) parent.proof = Proof::Win;
+
+					const float* playedN = amafN[mover].data();
+					const float* playedW = amafW[mover].data();
+					for (int i = 0; i < children.Size(); ++i)
+					{
+						children.nr[i] += playedN[children.moves[i]];
+						children.wr[i] += playedW[children.moves[i]];
 					}
-					isWinForNode = !isWinForNode;
 					whiteToMove = !whiteToMove;
 				}
 
-				tree.Data().n += 1.0f;
+				tree.Data()->n += k;
+				if (control.shareProofs && tree.Data()->proof != Proof::Unknown) control.solved = true;
 
-				for (int i : moveHist)
+				for (int i : path)
 				{
 					board.UndoMove(i);
-					legalMoves.insert(i);
 				}
-				moveHist.clear();
+				path.clear();
+				slots.clear();
 
-				auto end = std::chrono::high_resolution_clock::now();
-				auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-				elapsed += duration;
+				playouts += leafPlayouts;
 				D(if (!(cpy == board)) throw std::logic_error("Board should remain constant through iterations"));
-			}	
+			}
+
+			_RemoveImported(tree, imported);
+			control.playouts += playouts;
+			control.nodes += nodes;
+			--control.active;
+		}
+
+
+		//Lower bound of the Wilson score interval on the win rate w / n.
+		float _Lcb(float w, float n)
+		{
+			if (n == 0.0f) return 0.0f;
+			const float z = 1.96f;
+			float p = w / n;
+			float centre = p + z * z / (2.0f * n);
+			float spread = z * sqrt(p * (1.0f - p) / n + z * z / (4.0f * n * n));
+			return (centre - spread) / (1.0f + z * z / n);
+		}
+
+
+		//Value of a root move under the decision rule in params. Higher is better.
+		float _DecisionValue(const MoveStats& stats, const Params& params)
+		{
+			switch (params.decision)
+			{
+			case Decision::MaxLcb:
+				return _Lcb(stats.w, stats.n);
+
+			case Decision::MaxBlended:
+			{
+				if (stats.n == 0.0f) return 0.0f;
+				float beta = (stats.nr > 0.0f) ? _Beta(stats.n, stats.nr, params.b) : 0.0f;
+				float rave = (stats.nr > 0.0f) ? stats.wr / stats.nr : 0.0f;
+				return (1.0f - beta) * (stats.w / stats.n) + beta * rave;
+			}
+
+			case Decision::Vote:
+				return stats.votes;
+
+			default:
+				return stats.n;
+			}
+		}
+
+
+		//Returns thread's share of a budget split evenly between nthread threads.
+		//Budgets that do not divide evenly give the first threads one extra.
+		//A budget of zero (no limit) stays zero, so every thread gets at least
+		//one from a budget smaller than nthread.
+		long long _Share(long long budget, int nthread, int thread)
+		{
+			if (budget == 0) return 0;
+			long long share = budget / nthread + ((thread < budget % nthread) ? 1 : 0);
+			return std::max(share, 1LL);
 		}
 
 
 		int MonteCarloSearch(Board board, long long maxTime, int nthread, float expBias, float b)
 		{
-			Threadpool threadpool(nthread);
+			Params params;
+			params.expBias = expBias;
+			params.b = b;
+			return MonteCarloSearch(board, maxTime, nthread, params);
+		}
 
-			std::vector<GameTree> gameTrees;
-			for (int i = 0; i < nthread; ++i)
+
+		int MonteCarloSearch(Board board, long long maxTime, int nthread, const Params& params)
+		{
+			std::atomic<bool> stop(false);
+			return MonteCarloSearch(board, maxTime, nthread, params, stop);
+		}
+
+
+		int MonteCarloSearch(Board board, long long maxTime, int nthread, const Params& params, const std::atomic<bool>& stop)
+		{
+			Searcher searcher(board, nthread, params);
+			return searcher.Search(maxTime, stop);
+		}
+
+
+		int MonteCarloSearch(Board board, long long maxTime, int nthread, const std::vector<Params>& portfolio)
+		{
+			Searcher searcher(board, nthread, portfolio);
+			return searcher.Search(maxTime);
+		}
+
+
+		Searcher::Searcher(const Board& board, int nthread, const Params& params) :
+			Searcher(board, nthread, std::vector<Params>(1, params))
+		{
+		}
+
+
+		Searcher::Searcher(const Board& board, int nthread, const std::vector<Params>& portfolio) :
+			position(board), nthread(nthread), params(portfolio.at(0)), portfolio(portfolio), threadpool(nthread), ponderStop(false)
+		{
+			if (params.decision == Decision::Auto)
 			{
-				Node root;
-				gameTrees.push_back(GameTree(root));
+				params.decision = (portfolio.size() > 1) ? Decision::Vote : Decision::MaxVisits;
 			}
 
-			for (GameTree& tree : gameTrees)
+			for (Params& entry : this->portfolio)
 			{
-				threadpool.Submit([&tree, board, maxTime, expBias, b]()
-					{
-						_MonteCarloSearch(std::ref(tree), board, maxTime, expBias, b);
-					});
+				entry.earlyStop = params.earlyStop;
+				entry.transpositionEntries = params.transpositionEntries;
+				entry.solver = params.solver;
+				entry.solverEmpties = params.solverEmpties;
+				entry.solverNodes = params.solverNodes;
+				entry.syncInterval = params.syncInterval;
+				entry.decision = params.decision;
+				entry.sharedAmaf = params.sharedAmaf;
+				entry.amafContext = params.amafContext;
 			}
 
-			threadpool.WaitAll();
+			std::random_device rd;
+			Random rng(((uint64_t)rd() << 32) ^ rd());
+			for (int i = 0; i < nthread; ++i)
+			{
+				rngs.push_back(rng);
+				rng.Jump();
+				pools.push_back(std::make_unique<NodePool>());
+				if (params.transpositionEntries > 0) tables.push_back(TranspositionTable(params.transpositionEntries));
+			}
 
-			std::unordered_map<int, float> scores;
-			for (int i = 0; i < board.Area(); ++i)
-				if (board.IsLegalMove(i)) scores[i] = 0.0f;
+			Reset(board);
+		}
+
+
+		Searcher::~Searcher()
+		{
+			StopPondering();
+		}
+
+
+		int Searcher::Search(long long maxTime)
+		{
+			std::atomic<bool> stop(false);
+			return Search(maxTime, stop);
+		}
+
+
+		int Searcher::Search(long long maxTime, const std::atomic<bool>& stop)
+		{
+			Limits limits;
+			limits.time = maxTime;
+			return Search(limits, stop);
+		}
+
+
+		int Searcher::Search(const Limits& limits)
+		{
+			std::atomic<bool> stop(false);
+			return Search(limits, stop);
+		}
+
+
+		int Searcher::Search(const Limits& limits, const std::atomic<bool>& stop)
+		{
+			Clock::time_point start = Clock::now();
+			Clock::time_point deadline = (limits.time > 0) ? start + std::chrono::milliseconds(limits.time) : Clock::time_point::max();
+			StopPondering();
 
-			for (GameTree& tree : gameTrees)
+			//Few enough empty cells to try solving the position outright. Only a
+			//win is useful: against a proven loss MonteCarlo still picks the move
+			//most likely to trouble an imperfect opponent. Results are kept from
+			//one search to the next, so after the reply a proof expected the new
+			//position is usually solved at once, and after any other the solver
+			//still looks for the win the opponent may have given away.
+			if (params.solverEmpties > 0 && position.CountUnoccupied() <= params.solverEmpties)
 			{
-				for (auto& pair : scores)
+				Clock::time_point solverDeadline = (limits.time > 0) ? start + std::chrono::milliseconds(limits.time / 2) : deadline;
+				Solver::Result result = Solver::Solve(position, params.solverNodes, solverDeadline, stop, solved);
+				if (result.outcome == Solver::Outcome::Win)
 				{
-					if (tree.HasChild(pair.first))
-					{
-						pair.second += tree.Child(pair.first).n;
-					}
+					Clock::time_point end = Clock::now();
+					merged.clear();
+					info = SearchInfo();
+					info.solved = true;
+					info.nodes = result.nodes;
+					info.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+					if (limits.time > 0)
+						info.saved = std::max(0LL, (long long)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - end).count());
+					return result.move;
 				}
 			}
 
+			info = Run(deadline, limits, stop);
+
+			Clock::time_point end = Clock::now();
+			info.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+			if (limits.time > 0)
+				info.saved = std::max(0LL, (long long)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - end).count());
+
+			//A move any tree has proven winning is played straight away, and moves
+			//proven losing are only played if every move loses.
+			Merge();
+			for (const MoveStats& stats : merged)
+			{
+				if (stats.proof == Proof::Win) return stats.move;
+			}
+
 			float bestScore = -999.0f;
 			int bestMove = -1;
-			for (auto& pair : scores)
+			for (const MoveStats& stats : merged)
 			{
-				if (pair.second > bestScore)
+				float score = (stats.proof == Proof::Loss) ? -1.0f : _DecisionValue(stats, params);
+				if (score > bestScore)
 				{
-					bestMove = pair.first;
-					bestScore = pair.second;
+					bestMove = stats.move;
+					bestScore = score;
 				}
 			}
 
 			return bestMove;
 		}
+
+
+		void Searcher::StartPondering()
+		{
+			if (IsPondering()) return;
+			ponderStop = false;
+			ponderThread = std::thread([this]()
+				{
+					Run(Clock::time_point::max(), Limits(), ponderStop);
+				});
+		}
+
+
+		void Searcher::StopPondering()
+		{
+			if (!IsPondering()) return;
+			ponderStop = true;
+			ponderThread.join();
+		}
+
+
+		bool Searcher::IsPondering() const
+		{
+			return ponderThread.joinable();
+		}
+
+
+		void Searcher::MakeMove(int move)
+		{
+			StopPondering();
+			for (int i = 0; i < nthread; ++i)
+			{
+				GameTree& tree = trees[i];
+				tree.Reset();
+				if (tree.HasChild(move))
+				{
+					tree.Reroot(move);
+				}
+
+				else
+				{
+					tree.ClearAll();
+					tree.Data() = _FindNode(position.Hash() ^ ZobristKey((position.WhiteToMove()) ? Hexagon::White : Hexagon::Black, move),
+						(tables.empty()) ? nullptr : &tables[i], *pools[i]);
+				}
+			}
+
+			position.MakeMove(move);
+		}
+
+
+		void Searcher::SetPosition(const Board& board)
+		{
+			StopPondering();
+			if (board.Length() != position.Length())
+			{
+				Reset(board);
+				return;
+			}
+
+			//Moves in board that are not in the current position, in the
+			//order they must have been played.
+			std::vector<int> played;
+			Hexagon mover = (position.WhiteToMove()) ? Hexagon::White : Hexagon::Black;
+			for (int i = 0; i < board.Area(); ++i)
+			{
+				if (board[i] == position[i]) continue;
+				if (position[i] != Hexagon::Unoccupied)
+				{
+					Reset(board);
+					return;
+				}
+
+				if (board[i] == mover) played.insert(played.begin(), i);
+				else played.push_back(i);
+			}
+
+			bool isContinuation =
+				played.size() <= 2 &&
+				board.WhiteToMove() == (position.WhiteToMove() == (played.size() % 2 == 0)) &&
+				(played.empty() || board[played[0]] == mover) &&
+				(played.size() < 2 || board[played[1]] != mover);
+
+			if (!isContinuation)
+			{
+				Reset(board);
+				return;
+			}
+
+			for (int move : played)
+			{
+				MakeMove(move);
+			}
+		}
+
+
+		const Board& Searcher::Position() const
+		{
+			return position;
+		}
+
+
+		const SearchInfo& Searcher::Info() const
+		{
+			return info;
+		}
+
+
+		const std::vector<MoveStats>& Searcher::Merged() const
+		{
+			return merged;
+		}
+
+
+		void Searcher::Seed(uint64_t seed)
+		{
+			StopPondering();
+			Random rng(seed);
+			for (Random& r : rngs)
+			{
+				r = rng;
+				rng.Jump();
+			}
+			Forget();
+		}
+
+
+		void Searcher::Seed(const std::vector<uint64_t>& seeds)
+		{
+			D(if (seeds.size() != rngs.size()) throw std::invalid_argument("Need one seed per thread"));
+			StopPondering();
+			for (size_t i = 0; i < rngs.size(); ++i)
+			{
+				rngs[i].Seed(seeds[i]);
+			}
+			Forget();
+		}
+
+
+		void Searcher::Forget()
+		{
+			for (TranspositionTable& table : tables)
+			{
+				table.Clear();
+			}
+			solved.Clear();
+			Reset(Board(position));
+		}
+
+
+		SearchInfo Searcher::Run(Clock::time_point deadline, const Limits& limits, const std::atomic<bool>& stop)
+		{
+			const Board& board = position;
+			SearchControl control(deadline, stop, workspaces);
+			control.shareProofs = limits.playouts == 0 && limits.nodes == 0;
+
+			for (int i = 0; i < nthread; ++i)
+			{
+				const Params& params = portfolio[i % portfolio.size()];
+				GameTree& tree = trees[i];
+				Random& rng = rngs[i];
+				TranspositionTable* table = (tables.empty()) ? nullptr : &tables[i];
+				AmafTable* amaf = this->amaf.get();
+				Workspace& workspace = *workspaces[i];
+				long long maxPlayouts = _Share(limits.playouts, nthread, i);
+				long long maxNodes = _Share(limits.nodes, nthread, i);
+				tree.Reset();
+				workspace.policy.Clear();
+				threadpool.Submit([&tree, &board, &control, &params, &rng, table, amaf, &workspace, maxPlayouts, maxNodes, i]()
+					{
+						_MonteCarloSearch(std::ref(tree), board, control, params, rng, table, amaf, workspace, maxPlayouts, maxNodes, i);
+					});
+			}
+
+			//The visit lead only settles the choice of the most visited move.
+			if (params.earlyStop && params.decision == Decision::MaxVisits) _MonitorSearch(control, board.Area());
+			threadpool.WaitAll();
+
+			SearchInfo result;
+			result.playouts = control.playouts;
+			result.nodes = control.nodes;
+			return result;
+		}
+
+
+		void Searcher::Merge()
+		{
+			merged.clear();
+			std::vector<int> index(position.Area(), -1);
+			for (int i = 0; i < position.Area(); ++i)
+			{
+				if (!position.IsLegalMove(i)) continue;
+				index[i] = (int)merged.size();
+				merged.push_back({ i, 0.0f, 0.0f, 0.0f, 0.0f, Proof::Unknown, 0.0f });
+			}
+
+			for (GameTree& tree : trees)
+			{
+				const Children& children = tree.Data()->children;
+				int vote = _ArgMax(children.n.data(), children.Size());
+				if (vote != -1)
+				{
+					merged[index[children.moves[vote]]].votes += _Lcb(children.w[vote], children.n[vote]);
+				}
+
+				for (int i = 0; i < children.Size(); ++i)
+				{
+					MoveStats& stats = merged[index[children.moves[i]]];
+					stats.n += children.n[i];
+					stats.w += children.w[i];
+					stats.nr += children.nr[i];
+					stats.wr += children.wr[i];
+					if (children.proof[i] != Proof::Unknown) stats.proof = children.proof[i];
+				}
+			}
+		}
+
+
+		void Searcher::Reset(const Board& board)
+		{
+			position = board;
+			trees.clear();
+			workspaces.clear();
+			for (int i = 0; i < nthread; ++i)
+			{
+				trees.push_back(GameTree(_FindNode(board.Hash(), (tables.empty()) ? nullptr : &tables[i], *pools[i])));
+				workspaces.push_back(std::make_unique<Workspace>(board.Length(), portfolio[i % portfolio.size()], *pools[i]));
+			}
+
+			if (params.sharedAmaf) amaf = std::make_unique<AmafTable>(board.Area(), params.amafContext);
+		}
 	}
 }
\ No newline at end of file
@@ -1,8 +1,9 @@
 /*
  * Functinons to search the game tree for the next best move.
  *
- * Currently only MonteCarlo tree search with the AMAF heuristic
- * is implemented.
+ * Moves are chosen by MonteCarlo tree search with the AMAF heuristic,
+ * which hands positions with few empty cells to the exact solver
+ * (see solver.h).
  * 
  */
 
@@ -12,27 +13,367 @@
 #include "board.h"
 #include "pathfinding.h"
 #include "threadpool.h"
+#include "random.h"
+#include "transposition.h"
+#include "amaf.h"
+#include "playout.h"
+#include "solver.h"
+#include "prior.h"
 #include <time.h>
 #include <chrono>
 #include <random>
-#include <set>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
 
 
 namespace Hax
 {
 	namespace Search
 	{
+		/*
+		 * Rule for choosing the final move from the root statistics merged over
+		 * all trees (see MoveStats).
+		 * 
+		 * MaxVisits: The move with the most playouts.
+		 * 
+		 * MaxLcb: The move with the highest lower confidence bound on its win
+		 *         rate, which prefers a well tested move to a lucky one.
+		 * 
+		 * MaxBlended: The move with the highest win rate blended with its AMAF
+		 *             win rate, weighted as in selection.
+		 * 
+		 * Vote: Each tree votes for its own most visited move, weighted by the
+		 *       lower confidence bound on that move's win rate in the tree, and
+		 *       the move with the most weight wins. Suits portfolios (see
+		 *       Searcher), whose trees are not copies of one another.
+		 * 
+		 * Auto: Vote for a portfolio of more than one entry, otherwise MaxVisits.
+		*/
+		enum class Decision
+		{
+			MaxVisits,
+			MaxLcb,
+			MaxBlended,
+			Vote,
+			Auto
+		};
+
+
+		/*
+		 * Tuning parameters for MonteCarloSearch.
+		 * 
+		 * expBias, b: See MonteCarloSearch below.
+		 * 
+		 * firstPlayUrgency: If false, a node must have a child for every legal move
+		 *                   before the search may descend past it. If true, children
+		 *                   for all legal moves are created at once and unvisited ones
+		 *                   compete in selection with the score below, letting the
+		 *                   tree deepen on promising lines early.
+		 * 
+		 * fpu: Score given to an unvisited move in first-play urgency mode.
+		 *      Higher values try more unvisited moves before revisiting old ones.
+		 * 
+		 * raveInit: If true, unvisited moves with AMAF data are scored by their
+		 *           AMAF win rate instead of fpu.
+		 * 
+		 * earlyStop: If true and decision is MaxVisits, the search ends before
+		 *            maxTime once the most visited move leads the runner-up by
+		 *            more playouts than can still be made in the remaining time.
+		 *            The other decision rules always use the full time.
+		 * 
+		 * transpositionEntries: If positive, each thread keeps a transposition table
+		 *                       of this many entries, and nodes reaching the same
+		 *                       position by different move orders share one node
+		 *                       record, found through it, so the position is
+		 *                       expanded and stored once. Each parent's slot
+		 *                       also reads the position's combined visit and win
+		 *                       counts from it. 0 disables the table.
+		 * 
+		 * solver: If true, nodes whose move completes a real connection are proven
+		 *         wins, and proofs are propagated up the tree by minimax. Proven
+		 *         nodes are no longer searched, and the search returns as soon as
+		 *         any thread solves its root. With a playout or node budget only
+		 *         the solving thread stops, and the others run on to their own
+		 *         limits, so the result does not depend on thread timing.
+		 * 
+		 * solverEmpties: When this many empty cells or fewer remain, the position
+		 *                is first handed to the exact solver (see solver.h), and a
+		 *                winning move it finds is played without further search.
+		 *                Its results are kept between searches, so positions
+		 *                below one already solved are quick to solve. 0 disables
+		 *                the exact solver.
+		 * 
+		 * solverNodes: Max positions the exact solver may visit per search. It is
+		 *              also given at most half the time limit.
+		 * 
+		 * syncInterval: If positive, every this many milliseconds each thread
+		 *               publishes the statistics of its root children and adds
+		 *               the other threads' to its own, so that trees stop
+		 *               spending playouts on moves the others have refuted.
+		 *               Imported statistics are removed again when the search
+		 *               ends. 0 keeps the trees independent until the final
+		 *               vote, and is needed for reproducible searches.
+		 * 
+		 * decision: Rule for choosing the final move. See Decision.
+		 * 
+		 * sharedAmaf: If true, every thread also records its playouts in one AMAF
+		 *             table shared by the whole search (see amaf.h), and new
+		 *             children start with the table's statistics for their move
+		 *             as their AMAF counts. The table lasts until the searcher
+		 *             is given an unrelated position. With more than one thread
+		 *             what a new child starts with depends on how far the other
+		 *             threads have got, so only single-threaded searches with
+		 *             the shared table are reproducible.
+		 * 
+		 * amafContext: If true, the shared table is also keyed by the previous move.
+		 * 
+		 * amafPrior: Shared statistics seeding a child are scaled down to at most
+		 *            this many playouts, so the child's own AMAF results soon
+		 *            outweigh them.
+		 * 
+		 * leafPlayouts: Number of playouts run from each leaf the search reaches,
+		 *               whose results are backed up along the path together.
+		 *               More playouts per leaf spend less of each playout's time
+		 *               in the tree, at the cost of a tree that grows more slowly.
+		 *               Playout budgets may be overrun by up to one leaf's worth.
+		 * 
+		 * bridgeReply: Probability that a playout answers an intrusion into a
+		 *              two-bridge by restoring it. See playout.h.
+		 * 
+		 * lastGoodReply: If true, each thread's playouts replay the replies that
+		 *                won its earlier playouts, and forget those that lost.
+		 * 
+		 * patterns: If true, other playout moves are weighted by the pattern of
+		 *           their six neighbours rather than uniformly random.
+		 * 
+		 * mast: If true, other playout moves are drawn by Gibbs sampling on
+		 *       each thread's average result of the move over all its playouts
+		 *       so far, in place of the patterns.
+		 * 
+		 * mastTemperature: Gibbs temperature of the MAST weights.
+		 * 
+		 * prior: Static move scorer (see prior.h) consulted when a node is
+		 *        expanded. Kind::None disables the options below.
+		 * 
+		 * priorWeight: Progressive bias. Each child's selection score gains
+		 *              priorWeight * prior / (n + 1), which fades as the child
+		 *              gathers visits of its own.
+		 * 
+		 * widening: If positive, progressive widening: children are taken in
+		 *           order of prior, and a node only offers its first widening
+		 *           to selection, plus one more each time its visits grow by a
+		 *           factor of wideningGrowth (and one per proven child).
+		 *           0 offers every child at once. Either way, nodes without
+		 *           first-play urgency expand their children best prior first.
+		 * 
+		 * wideningGrowth: Factor by which visits must grow to widen a node by
+		 *                 one more child. Must be greater than 1.
+		 * 
+		 * truncateMoves: If positive, playouts stop after this many moves and
+		 *                are scored by a static evaluation of the position: a
+		 *                logistic function of the difference in the players'
+		 *                connection distances, backed up as a fractional win.
+		 *                0 plays every playout to the end.
+		 * 
+		 * truncateMargin: If positive, playouts also stop, every few moves, once
+		 *                 one player's connection distance is shorter than the
+		 *                 other's by this many cells or more.
+		 * 
+		 * truncateScale: Slope of the evaluation: the log-odds of winning per
+		 *                cell of lead in connection distance.
+		 * 
+		 * symmetryDepth: Nodes less than this many moves below the root whose
+		 *                position is unchanged by a half turn of the board (such
+		 *                as the empty board) only expand one move of each pair
+		 *                the half turn swaps, doubling the playouts each distinct
+		 *                move gets. 1 checks just the root, and 0 disables it.
+		*/
+		struct Params
+		{
+			float expBias = 0.0f;
+			float b = 1.0f;
+			bool firstPlayUrgency = false;
+			float fpu = 1.0f;
+			bool raveInit = true;
+			bool earlyStop = true;
+			size_t transpositionEntries = 0;
+			bool solver = true;
+			int solverEmpties = 20;
+			long long solverNodes = 100000;
+			long long syncInterval = 0;
+			Decision decision = Decision::Auto;
+			bool sharedAmaf = false;
+			bool amafContext = false;
+			float amafPrior = 20.0f;
+			int leafPlayouts = 1;
+			float bridgeReply = 1.0f;
+			bool lastGoodReply = false;
+			bool patterns = false;
+			bool mast = false;
+			float mastTemperature = 0.1f;
+			Prior::Kind prior = Prior::Kind::None;
+			float priorWeight = 1.0f;
+			int widening = 0;
+			float wideningGrowth = 1.4f;
+			int truncateMoves = 0;
+			int truncateMargin = 0;
+			float truncateScale = 1.0f;
+			int symmetryDepth = 1;
+		};
+
+
+		/*
+		 * Budget for a single search. Zero means no limit on that resource,
+		 * and the search ends when the first limit is reached. With no limits
+		 * at all the search runs until stopped.
+		 * 
+		 * time: Wall-clock time in milliseconds.
+		 * 
+		 * playouts: Total playouts, split evenly between the threads.
+		 * 
+		 * nodes: Total tree nodes added, split evenly between the threads.
+		 * 
+		 * Every thread searches, so budgets of fewer playouts or nodes than
+		 * there are threads are rounded up to one per thread.
+		 * 
+		 * Without a time limit each thread's search depends only on the position,
+		 * its share of the budget and its seed (see Searcher::Seed), so a search
+		 * is reproducible and its speed can be measured separately from its
+		 * result. This holds only while the threads share nothing as they
+		 * search: syncInterval must be 0, and sharedAmaf off unless there is one
+		 * thread.
+		*/
+		struct Limits
+		{
+			long long time = 0;
+			long long playouts = 0;
+			long long nodes = 0;
+		};
+
+
+		//Statistics of the last completed search. Times are in milliseconds.
+		//saved is the part of the time limit left unused, e.g. for a game clock to bank.
+		//solved is true if the move came from the exact solver.
+		struct SearchInfo
+		{
+			long long elapsed = 0;
+			long long saved = 0;
+			long long playouts = 0;
+			long long nodes = 0;
+			bool solved = false;
+		};
+
+
+		//Game-theoretic value of a node, from the point of view of the
+		//player who moved into it (as for the node's wins).
+		enum class Proof
+		{
+			Unknown,
+			Win,
+			Loss
+		};
+
+
+		//Root statistics of one legal move, summed over all trees. A move is
+		//proven if any tree has proven it. votes is its weight under
+		//Decision::Vote.
+		struct MoveStats
+		{
+			int move;
+			float n;
+			float w;
+			float nr;
+			float wr;
+			Proof proof;
+			float votes;
+		};
+
+
+		/*
+		 * Statistics of a node's children, one slot per child, stored as parallel
+		 * arrays so that selection can score every child in a single vectorised
+		 * pass instead of looking each one up in the tree.
+		 * 
+		 * A slot's tree node is only created the first time the search descends
+		 * to it, so first-play urgency nodes pay for a slot per legal move but not
+		 * for a tree node per legal move.
+		*/
+		struct Children
+		{
+			//Appends a slot for move and returns its index.
+			int Add(int move, uint64_t key, TTEntry* entry);
+
+			int Size() const;
+
+			std::vector<int> moves;
+			std::vector<float> n;
+			std::vector<float> w;
+			std::vector<float> nr;
+			std::vector<float> wr;
+
+			//Static prior of each child's move, 0 without a prior scorer.
+			std::vector<float> prior;
+
+			//Proofs of the children, and how many are not Unknown.
+			std::vector<Proof> proof;
+			int proven = 0;
+
+			//Hash of each child's position and its shared statistics, if any.
+			//An entry may since have been given to another position, so check
+			//its key against the slot's before use.
+			std::vector<uint64_t> keys;
+			std::vector<TTEntry*> entries;
+		};
+
+
+		struct Node
+		{
+			Node() : n(0.0f), initialised(false), proof(Proof::Unknown) {}
+
+			//Visits of this node. Its children's statistics are in children.
+			float n;
+			Children children;
+
+			//Legal moves not yet expanded as children, popped in random order,
+			//or with a prior scorer in order of prior from the back, when
+			//priors holds the prior of each.
+			//Filled the first time the node is reached during selection.
+			std::vector<int> untried;
+			std::vector<float> priors;
+			bool initialised;
+
+			Proof proof;
+		};
+
+
+		//Node records are shared by every path reaching the same position
+		//when the transposition table is on, so the tree is really a DAG.
+		using NodePtr = std::shared_ptr<Node>;
+		using GameTree = Tree<int, NodePtr>;
+		using Clock = std::chrono::steady_clock;
+
+
+		//Working space of one search thread, and storage for the node records
+		//of its tree. See search.cpp.
+		struct Workspace;
+		class NodePool;
+
+
 		/* 
 		 * Returns the next AI move for the given board state.
 		 * 
 		 * Board: Instance of Board class representing the current board state
 		 * 
-		 * maxTime: Max time allowed in milliseconds.
+		 * maxTime: Max time allowed in milliseconds. All threads share one deadline
+		 *          measured from the call, and the move is returned within about a
+		 *          millisecond of it (or one search iteration, if that is longer).
 		 * 
 		 * nthread: Number of parallel executions. For best results set to maximum
-		 *          cpu cores. If you set it any higher, the algorithm will likely
-		 *          overrun the maximum time allotted. 
+		 *          cpu cores. Setting it higher costs playouts per thread but no
+		 *          longer overruns the time allotted.
 		 * 
 		 * expBias: MonteCarlo tuning parameter. A higher value will favour exploring
 		 *          a variety of moves, while a lower value hones in on the most 
@@ -45,6 +386,143 @@ namespace Hax
 		 *    than expBias.
 		*/
 		int MonteCarloSearch(Board board, long long maxTime, int nthread, float expBias = 0.0f, float b = 1.0f);
+
+		//As above, with the full set of tuning parameters.
+		int MonteCarloSearch(Board board, long long maxTime, int nthread, const Params& params);
+
+		//As above. Setting stop from another thread ends the search early and
+		//returns the best move found so far.
+		int MonteCarloSearch(Board board, long long maxTime, int nthread, const Params& params, const std::atomic<bool>& stop);
+
+		//As above, with a portfolio of parameters for the threads. See Searcher.
+		int MonteCarloSearch(Board board, long long maxTime, int nthread, const std::vector<Params>& portfolio);
+
+
+		/*
+		 * Stateful MonteCarlo search over the positions of a single game.
+		 * 
+		 * One tree per thread is kept between searches. As the game advances
+		 * each tree is re-rooted on the moves actually played, freeing the rest,
+		 * so the next search starts from the statistics already gathered below
+		 * the new position rather than from scratch.
+		 * 
+		 * While waiting for the opponent the searcher can ponder: the search keeps
+		 * running on the current position in the background until the reply is
+		 * played, so the subtree under it is already deep when Search is called.
+		 * 
+		 * Everything else a search needs is kept too: the worker threads wait
+		 * in a pool between searches, node records come from preallocated
+		 * storage per thread that takes back the records of freed nodes, and
+		 * each thread's scratch buffers and playout policy last until the
+		 * searcher is given an unrelated position, so even a very short search
+		 * spends its time searching. Learnt playout replies and move averages
+		 * still start afresh with each search. The tree's own nodes, which
+		 * hold the links to the records (see Tree), are not pooled: each node
+		 * added to a tree still allocates itself and its entry in the parent's
+		 * child map on the heap.
+		 * 
+		 * Threads may search with different parameters, a portfolio, so their
+		 * trees explore differently rather than duplicating one another. Thread
+		 * i uses portfolio[i % portfolio.size()]. Settings of the search as a
+		 * whole rather than of one tree (earlyStop, transpositionEntries, the
+		 * solver, syncInterval, decision and the shared AMAF table) are taken
+		 * from the first entry. Unless told otherwise, a portfolio of more than
+		 * one entry chooses its move by confidence-weighted vote.
+		*/
+		class Searcher
+		{
+		public:
+			Searcher(const Board& board, int nthread, const Params& params = Params());
+			Searcher(const Board& board, int nthread, const std::vector<Params>& portfolio);
+			~Searcher();
+
+			//Returns the next AI move for the current position. See MonteCarloSearch.
+			int Search(long long maxTime);
+			int Search(long long maxTime, const std::atomic<bool>& stop);
+			int Search(const Limits& limits);
+			int Search(const Limits& limits, const std::atomic<bool>& stop);
+
+			//Starts searching the current position in the background until
+			//StopPondering is called or the position changes.
+			void StartPondering();
+
+			//Stops a background search and waits for it to finish.
+			void StopPondering();
+
+			bool IsPondering() const;
+
+			//Plays the given move on the current position, keeping the subtree below it.
+			//Stops pondering first.
+			void MakeMove(int move);
+
+			//Sets the current position. If it follows from the current position by
+			//our move and/or the opponent's reply, the subtrees below those moves
+			//are kept. Otherwise the search restarts from empty trees. Stops pondering first.
+			void SetPosition(const Board& board);
+
+			const Board& Position() const;
+
+			const SearchInfo& Info() const;
+
+			//Returns the root statistics of every legal move, merged over all
+			//trees at the end of the last search, in order of move. Empty if
+			//the last move came from the exact solver.
+			const std::vector<MoveStats>& Merged() const;
+
+			//Reseeds the per-thread random number generators, either from one
+			//seed split into a stream per thread, or from one seed per thread.
+			//Everything learnt by earlier searches is discarded too, so that
+			//searches after the same seed make the same playouts.
+			void Seed(uint64_t seed);
+			void Seed(const std::vector<uint64_t>& seeds);
+
+		private:
+			//Runs one search per tree on the current position until the deadline
+			//passes, the limits are used up or stop is set. Returns the number
+			//of playouts made and nodes added.
+			SearchInfo Run(Clock::time_point deadline, const Limits& limits, const std::atomic<bool>& stop);
+
+			void Reset(const Board& board);
+
+			//Discards the trees, tables and learnt playout policies, keeping
+			//the position.
+			void Forget();
+
+			//Sums the root statistics of every tree into merged.
+			void Merge();
+
+			Board position;
+			int nthread;
+			//Search-wide parameters, the first of the portfolio.
+			Params params;
+			std::vector<Params> portfolio;
+			//Declared before the trees and tables, which release into them.
+			std::vector<std::unique_ptr<NodePool>> pools;
+			Threadpool threadpool;
+			std::vector<GameTree> trees;
+			std::vector<std::unique_ptr<Workspace>> workspaces;
+			std::vector<Random> rngs;
+			std::vector<TranspositionTable> tables;
+			std::unique_ptr<AmafTable> amaf;
+			SearchInfo info;
+			std::vector<MoveStats> merged;
+			//Positions the exact solver has solved, kept between searches.
+			Solver::Table solved;
+			std::thread ponderThread;
+			std::atomic<bool> ponderStop;
+		};
+
+
+		//Internals of search.cpp, declared here so they can be tested. See
+		//there for what each does.
+		float _Score(float n, float w, float nr, float wr, float N_i, const Params& params);
+		void _ScoreAll(const float* n, const float* w, const float* nr, const float* wr, const float* prior,
+			int size, float N_i, const Params& params, float* scores);
+		int _ArgMax(const float* scores, int size);
+		int _SelectChild(const Node& node, const Params& params, bool useTable, std::vector<float>& scratch);
+		float _Evaluate(const Board& board, const Params& params, int& margin);
+		float _Lcb(float w, float n);
+		long long _Share(long long budget, int nthread, int thread);
 	}
 }
 
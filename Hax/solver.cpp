@@ -0,0 +1,170 @@
+#include "solver.h"
+
+namespace Hax
+{
+	namespace Solver
+	{
+		//Number of transposition table entries (a power of two).
+		const size_t TABLE_SIZE = 1 << 18;
+
+
+		struct State
+		{
+			State(long long maxNodes, std::chrono::steady_clock::time_point deadline, const std::atomic<bool>& stop, Table& table) :
+				table(table.entries), nodes(0), maxNodes(maxNodes), deadline(deadline), stop(stop), aborted(false)
+			{
+				if (this->table.empty()) this->table.resize(TABLE_SIZE);
+			}
+
+			std::vector<Table::Entry>& table;
+			long long nodes;
+			long long maxNodes;
+			std::chrono::steady_clock::time_point deadline;
+			const std::atomic<bool>& stop;
+			bool aborted;
+		};
+
+
+		//Candidate moves for the player to move, in the order to try them.
+		//Sets immediateWin if the first candidate wins on the spot, and returns
+		//no candidates if the opponent has two separate winning cells.
+		std::vector<int> _Candidates(const Board& board, bool& immediateWin)
+		{
+			static thread_local int ownStart[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+			static thread_local int ownEnd[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+			static thread_local int oppStart[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+			static thread_local int oppEnd[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+
+			bool white = board.WhiteToMove();
+			Pathfinding::EdgeDistances(board, white, ownStart, ownEnd);
+			Pathfinding::EdgeDistances(board, !white, oppStart, oppEnd);
+			immediateWin = false;
+
+			//(priority, cell) pairs; smaller priorities are tried first
+			std::vector<std::pair<int, int>> moves;
+			std::vector<int> threats;
+			for (int i = 0; i < board.Area(); ++i)
+			{
+				if (!board.IsLegalMove(i)) continue;
+
+				//Empty cells count in both directions, so remove one copy
+				int own = std::min(ownStart[i] + ownEnd[i] - 1, Pathfinding::UNREACHABLE);
+				int opp = std::min(oppStart[i] + oppEnd[i] - 1, Pathfinding::UNREACHABLE);
+				if (own == 1)
+				{
+					immediateWin = true;
+					return std::vector<int>(1, i);
+				}
+
+				if (opp == 1) threats.push_back(i);
+
+				//A cell on no path for either player is never better than any other move
+				if (own >= Pathfinding::UNREACHABLE && opp >= Pathfinding::UNREACHABLE) continue;
+				moves.push_back(std::make_pair(std::min(own, opp) * 2 * Pathfinding::UNREACHABLE + own + opp, i));
+			}
+
+			//Extra stones never hurt in Hex, so if the opponent threatens to win
+			//at once we must block, and two threats cannot both be blocked.
+			if (threats.size() == 1) return threats;
+			if (threats.size() > 1) return std::vector<int>();
+
+			std::sort(moves.begin(), moves.end());
+			std::vector<int> result;
+			result.reserve(moves.size());
+			for (const std::pair<int, int>& move : moves)
+			{
+				result.push_back(move.second);
+			}
+			return result;
+		}
+
+
+		//Returns true if the player to move can force a win.
+		//Sets bestMove to a winning move if there is one.
+		bool _Wins(Board& board, State& state, int& bestMove)
+		{
+			bestMove = -1;
+			if (++state.nodes > state.maxNodes || state.stop.load(std::memory_order_relaxed) ||
+				((state.nodes & 1023) == 0 && std::chrono::steady_clock::now() > state.deadline))
+			{
+				state.aborted = true;
+			}
+			if (state.aborted) return false;
+
+			Table::Entry& entry = state.table[board.Hash() & (TABLE_SIZE - 1)];
+			if (entry.key == board.Hash())
+			{
+				bestMove = entry.move;
+				return entry.move != -1;
+			}
+
+			bool immediateWin;
+			std::vector<int> candidates = _Candidates(board, immediateWin);
+			if (immediateWin)
+			{
+				bestMove = candidates[0];
+				return true;
+			}
+
+			for (int move : candidates)
+			{
+				int reply;
+				board.MakeMove(move);
+				bool opponentWins = _Wins(board, state, reply);
+				board.UndoMove(move);
+				if (state.aborted) return false;
+
+				if (!opponentWins)
+				{
+					bestMove = move;
+					entry.key = board.Hash();
+					entry.move = move;
+					return true;
+				}
+			}
+
+			entry.key = board.Hash();
+			entry.move = -1;
+			return false;
+		}
+
+
+		void Table::Clear()
+		{
+			std::vector<Entry>().swap(entries);
+		}
+
+
+		Result Solve(const Board& board, long long maxNodes, std::chrono::steady_clock::time_point deadline)
+		{
+			std::atomic<bool> stop(false);
+			Table table;
+			return Solve(board, maxNodes, deadline, stop, table);
+		}
+
+
+		Result Solve(const Board& board, long long maxNodes, std::chrono::steady_clock::time_point deadline,
+			const std::atomic<bool>& stop, Table& table)
+		{
+			Result result;
+			result.outcome = Outcome::Unknown;
+			result.move = -1;
+			result.nodes = 0;
+
+			//Nothing to solve once either player is connected
+			if (Pathfinding::ConnectionDistance(board, true) == 0 || Pathfinding::ConnectionDistance(board, false) == 0)
+				return result;
+
+			Board copy(board);
+			State state(maxNodes, deadline, stop, table);
+			int move;
+			bool win = _Wins(copy, state, move);
+			result.nodes = state.nodes;
+			if (state.aborted) return result;
+
+			result.outcome = (win) ? Outcome::Win : Outcome::Loss;
+			result.move = move;
+			return result;
+		}
+	}
+}
\ No newline at end of file
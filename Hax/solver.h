@@ -0,0 +1,95 @@
+/*
+ * Exact solver for Hex positions with few empty cells.
+ * 
+ * Near the end of a game MonteCarlo sampling is slower and less reliable
+ * than simply searching every line, so the search switches to this once
+ * the number of empty cells drops below a threshold.
+ * 
+ * The solver is a win/loss negamax (alpha-beta with a null window) over
+ * the remaining moves, with a transposition table keyed by the board's
+ * Zobrist hash. Connection distances for both players are used at every
+ * node to:
+ *   - detect immediate wins without playing them out,
+ *   - restrict the reply to the opponent's single winning cell, or give up
+ *     when the opponent has two,
+ *   - skip dead cells that lie on no path for either player,
+ *   - order the remaining moves, most contested first.
+*/
+
+
+#pragma once
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include "board.h"
+#include "pathfinding.h"
+#include "debug.h"
+
+
+namespace Hax
+{
+	namespace Solver
+	{
+		enum class Outcome
+		{
+			Unknown,
+			Win,
+			Loss
+		};
+
+
+		struct Result
+		{
+			//Outcome for the player to move. Unknown if the search ran out of budget.
+			Outcome outcome;
+
+			//A winning move if outcome is Win, otherwise -1.
+			int move;
+
+			//Number of positions visited.
+			long long nodes;
+		};
+
+
+		//Results of the positions solved so far, keyed by position hash. A
+		//result holds whatever the game the position arose in, so a table
+		//given to one call after another lets later calls reuse earlier work,
+		//such as re-solving a position after the reply a proof expected.
+		class Table
+		{
+		public:
+			struct Entry
+			{
+				Entry() : key(0), move(-1) {}
+				uint64_t key;
+
+				//Winning move, or -1 if the position is lost.
+				int move;
+			};
+
+			//Frees the entries, which are allocated by the first Solve.
+			void Clear();
+
+		private:
+			friend struct State;
+			std::vector<Entry> entries;
+		};
+
+
+		/*
+		 * Solves the board for the player to move.
+		 * 
+		 * maxNodes: Max positions to visit before giving up.
+		 * 
+		 * deadline: Time after which to give up.
+		 * 
+		 * stop: Gives up as soon as this is set, e.g. by another thread.
+		 * 
+		 * table: Results of earlier calls to reuse, and to add this call's to.
+		*/
+		Result Solve(const Board& board, long long maxNodes,
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+		Result Solve(const Board& board, long long maxNodes, std::chrono::steady_clock::time_point deadline,
+			const std::atomic<bool>& stop, Table& table);
+	}
+}
\ No newline at end of file
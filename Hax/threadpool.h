@@ -1,15 +1,20 @@
 /*
- * Class to manage a pool of threads (WORK IN PROGRESS).
+ * Class to manage a pool of threads.
  * 
- * A global mutex is used for synchronisation, and
- * a condition variable to simulate queueing up new threads.
+ * The worker threads are started once, by the constructor, and wait for
+ * tasks between submissions, so submitting work does not pay for starting
+ * an OS thread. A global mutex is used for synchronisation, and condition
+ * variables to hand tasks to idle workers and to wait for them to finish.
  */
 
 
 #pragma once
 #include <thread>
 #include <vector>
+#include <deque>
+#include <functional>
 #include <mutex>
+#include <condition_variable>
 
 
 namespace Hax
@@ -17,34 +22,33 @@ namespace Hax
 	class Threadpool
 	{
 	public:
-		Threadpool(size_t nthread) : nthread(nthread), threadpool(nthread), isActive(nthread, false), numActive(0) {}
+		Threadpool(size_t nthread) : numActive(0), nthread(nthread), stopping(false)
+		{
+			for (size_t i = 0; i < nthread; ++i)
+			{
+				threadpool.emplace_back([this]() { Work(); });
+			}
+		}
+
+		Threadpool(const Threadpool&) = delete;
+		Threadpool& operator=(const Threadpool&) = delete;
 		
-		//Execute the given function with the provided arguments in it's own thread
-		//and add it to the threadpool.
+		//Execute the given function with the provided arguments on one of the
+		//pool's threads. Waits for a thread to become free if all are busy.
 		template<class Function, class... Args>
 		void Submit(Function&& f, Args&&... args)
 		{
 			std::unique_lock<std::mutex> lock(mtx);
-			if (Full())
-			{
-				//Notified by: MarkFinished
-				cv.wait(lock);
-			}
-			size_t threadInd = GetFirstInactive();
-			if (threadpool[threadInd].joinable())
-			{
-				//Mark the old thread as finished
-				threadpool[threadInd].join();
-			}
 
-			threadpool[threadInd] = std::thread([threadInd, this, f, args...]()
+			//Notified by: Work, when a task finishes
+			idle.wait(lock, [this]() { return !Full(); });
+			tasks.push_back([f, args...]()
 				{
 					f(args...);
-					MarkFinished(threadInd);
 				});
 
 			++numActive;
-			isActive[threadInd] = true;
+			ready.notify_one();
 		}
 
 		//Returns true if all threads are busy
@@ -58,52 +62,66 @@ namespace Hax
 			return numActive;
 		}
 
-		//Joins all active threads
+		//Waits for every submitted task to finish. The threads stay alive
+		//for further tasks.
 		void WaitAll()
 		{
-			for (std::thread& t : threadpool)
-			{
-				if (t.joinable()) t.join();
-			}
+			std::unique_lock<std::mutex> lock(mtx);
+			idle.wait(lock, [this]() { return numActive == 0; });
 		}
 
 		~Threadpool()
 		{
 			WaitAll();
+			{
+				std::lock_guard<std::mutex> lk(mtx);
+				stopping = true;
+			}
+
+			ready.notify_all();
+			for (std::thread& t : threadpool)
+			{
+				t.join();
+			}
 		}
 
 
 	private:
-		//Register thread as finished so it can be replaced by a new one
-		void MarkFinished(int threadInd)
-		{
-			std::lock_guard<std::mutex> lk(mtx);
-			isActive[threadInd] = false;
-			--numActive;
-			cv.notify_one();
-		}
-
-		//Returns the index of the first inactive thread
-		size_t GetFirstInactive()
+		//Runs tasks as they are submitted until the pool is destroyed.
+		void Work()
 		{
-			for (size_t i = 0; i < nthread; ++i)
+			while (true)
 			{
-				if (!isActive[i])
+				std::function<void()> task;
 				{
-					return i;
+					std::unique_lock<std::mutex> lock(mtx);
+
+					//Notified by: Submit and the destructor
+					ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+					if (tasks.empty()) return;
+					task = std::move(tasks.front());
+					tasks.pop_front();
 				}
+
+				task();
+				{
+					std::lock_guard<std::mutex> lk(mtx);
+					--numActive;
+				}
+				idle.notify_all();
 			}
-			
-			//error
-			return nthread + 1;
 		}
 
 		std::vector<std::thread> threadpool;
-		std::vector<bool> isActive;
+		std::deque<std::function<void()>> tasks;
+
+		//Tasks submitted and not yet finished, never more than nthread.
 		size_t numActive;
 		size_t nthread;
+		bool stopping;
 		std::mutex mtx;
-		std::condition_variable cv;
+		std::condition_variable ready;
+		std::condition_variable idle;
 	};
 }
 
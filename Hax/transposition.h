@@ -0,0 +1,114 @@
+/*
+ * Fixed-size hash table of search statistics keyed by position hash.
+ * 
+ * Used to share statistics, and the node record itself, between tree
+ * paths that reach the same position by different move orders, which in
+ * Hex is very common. The record is held weakly, so it is freed once no
+ * tree reaches it any more.
+ * 
+ * The table is divided into buckets of BUCKET_SIZE entries. A key may only
+ * live in its own bucket, and when the bucket is full the entry with the
+ * fewest visits is replaced, since it holds the least information.
+ * Callers must therefore check that an entry's key still matches before
+ * relying on it.
+*/
+
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include "debug.h"
+
+
+namespace Hax
+{
+	namespace Search
+	{
+		struct Node;
+
+		struct TTEntry
+		{
+			TTEntry() : key(0), n(0.0f), w(0.0f) {}
+			uint64_t key;
+			float n;
+			float w;
+			std::weak_ptr<Node> node;
+		};
+
+
+		class TranspositionTable
+		{
+		public:
+			static const size_t BUCKET_SIZE = 4;
+
+			//Creates a table holding at least size entries (rounded up to a power of two).
+			//A key of 0 marks an empty entry, so 0 must not be used as a key.
+			TranspositionTable(size_t size)
+			{
+				size_t buckets = 1;
+				while (buckets * BUCKET_SIZE < size) buckets *= 2;
+				mask = buckets - 1;
+				entries.resize(buckets * BUCKET_SIZE);
+			}
+
+			//Returns the entry for key, or nullptr if it is not stored.
+			TTEntry* Find(uint64_t key)
+			{
+				D(if (key == 0) throw std::invalid_argument("0 is reserved for empty entries"));
+				TTEntry* bucket = Bucket(key);
+				for (size_t i = 0; i < BUCKET_SIZE; ++i)
+				{
+					if (bucket[i].key == key) return &bucket[i];
+				}
+				return nullptr;
+			}
+
+			//Returns the entry for key, creating it if it is not stored.
+			//A new entry replaces the least visited entry of its bucket.
+			TTEntry* Insert(uint64_t key)
+			{
+				TTEntry* found = Find(key);
+				if (found) return found;
+
+				TTEntry* bucket = Bucket(key);
+				TTEntry* victim = &bucket[0];
+				for (size_t i = 0; i < BUCKET_SIZE; ++i)
+				{
+					if (bucket[i].key == 0)
+					{
+						victim = &bucket[i];
+						break;
+					}
+
+					if (bucket[i].n < victim->n) victim = &bucket[i];
+				}
+
+				*victim = TTEntry();
+				victim->key = key;
+				return victim;
+			}
+
+			//Returns the number of entries the table can hold.
+			size_t Size() const
+			{
+				return entries.size();
+			}
+
+			void Clear()
+			{
+				std::fill(entries.begin(), entries.end(), TTEntry());
+			}
+
+		private:
+			TTEntry* Bucket(uint64_t key)
+			{
+				return &entries[(size_t)(key & mask) * BUCKET_SIZE];
+			}
+
+			std::vector<TTEntry> entries;
+			uint64_t mask;
+		};
+	}
+}
\ No newline at end of file
@@ -151,6 +151,17 @@ namespace Hax
 			return ptr->children[key]->data;
 		}
 
+		//Makes the child of the current node with the specified key the new root,
+		//destroying the rest of the tree. The current node is set to the new root.
+		void Reroot(const K& key)
+		{
+			D(if (!HasChild(key)) throw std::out_of_range("key not found"));
+			Pointer newRoot = std::move(ptr->children[key]);
+			newRoot->parent = nullptr;
+			root = std::move(newRoot);
+			ptr = root.get();
+		}
+
 		//Destroys the tree leaving an empty root with no children.
 		void ClearAll()
 		{
@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "amaf.h"
+
+
+TEST(TestAmafTable, TestUpdateGet)
+{
+	Hax::Search::AmafTable table(9, false);
+	float n, w;
+	table.Get(true, table.NoContext(), 4, n, w);
+	EXPECT_EQ(n, 0.0f);
+	EXPECT_EQ(w, 0.0f);
+
+	table.Update(true, table.NoContext(), 4, true);
+	table.Update(true, 2, 4, false);
+	table.Get(true, 7, 4, n, w);
+	EXPECT_EQ(n, 2.0f);
+	EXPECT_EQ(w, 1.0f);
+
+	//players are kept apart
+	table.Get(false, table.NoContext(), 4, n, w);
+	EXPECT_EQ(n, 0.0f);
+
+	table.Clear();
+	table.Get(true, table.NoContext(), 4, n, w);
+	EXPECT_EQ(n, 0.0f);
+}
+
+
+TEST(TestAmafTable, TestContext)
+{
+	Hax::Search::AmafTable table(9, true);
+	table.Update(false, 3, 8, true);
+	table.Update(false, table.NoContext(), 8, false);
+
+	float n, w;
+	table.Get(false, 3, 8, n, w);
+	EXPECT_EQ(n, 1.0f);
+	EXPECT_EQ(w, 1.0f);
+
+	table.Get(false, table.NoContext(), 8, n, w);
+	EXPECT_EQ(n, 1.0f);
+	EXPECT_EQ(w, 0.0f);
+
+	table.Get(false, 2, 8, n, w);
+	EXPECT_EQ(n, 0.0f);
+}
\ No newline at end of file
@@ -100,4 +100,34 @@ TEST(TestBoard, TestIsLegalMove)
 	EXPECT_TRUE(board.IsLegalMove(0));
 	board.MakeMove(0);
 	EXPECT_FALSE(board.IsLegalMove(0));
+}
+
+
+TEST(TestBoard, TestHash)
+{
+	Hax::Board a(10);
+	Hax::Board b(10);
+	EXPECT_EQ(a.Hash(), b.Hash());
+
+	//same position reached in a different order
+	a.MakeMove(1);
+	a.MakeMove(2);
+	a.MakeMove(3);
+	b.MakeMove(3);
+	b.MakeMove(2);
+	b.MakeMove(1);
+	EXPECT_EQ(a.Hash(), b.Hash());
+
+	uint64_t before = a.Hash();
+	a.MakeMove(4);
+	EXPECT_NE(a.Hash(), before);
+	a.UndoMove(4);
+	EXPECT_EQ(a.Hash(), before);
+
+	//same cells, different colors
+	Hax::Board c(10);
+	c.MakeMove(2);
+	c.MakeMove(1);
+	c.MakeMove(3);
+	EXPECT_NE(a.Hash(), c.Hash());
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "pch.h"
+#include "fenwick.h"
+
+
+TEST(TestFenwickTree, TestSetTotal)
+{
+	const float weights[] = { 1.0f, 2.0f, 0.0f, 4.0f, 8.0f };
+	Hax::FenwickTree tree;
+	tree.Assign(weights, 5);
+	EXPECT_EQ(tree.Size(), 5);
+	EXPECT_DOUBLE_EQ(tree.Total(), 15.0);
+
+	tree.Set(4, 0.0f);
+	tree.Set(2, 0.5f);
+	EXPECT_DOUBLE_EQ(tree.Total(), 7.5);
+	EXPECT_EQ(tree.Weight(2), 0.5f);
+	EXPECT_EQ(tree.Weight(4), 0.0f);
+}
+
+
+TEST(TestFenwickTree, TestFind)
+{
+	const float weights[] = { 1.0f, 2.0f, 0.0f, 4.0f, 8.0f, 1.0f };
+	Hax::FenwickTree tree;
+	tree.Assign(weights, 6);
+	EXPECT_EQ(tree.Find(0.0), 0);
+	EXPECT_EQ(tree.Find(0.99), 0);
+	EXPECT_EQ(tree.Find(1.0), 1);
+	EXPECT_EQ(tree.Find(2.99), 1);
+
+	//indices of weight 0 are skipped
+	EXPECT_EQ(tree.Find(3.0), 3);
+	EXPECT_EQ(tree.Find(7.5), 4);
+	EXPECT_EQ(tree.Find(15.5), 5);
+
+	tree.Set(3, 0.0f);
+	EXPECT_EQ(tree.Find(3.0), 4);
+}
+
+
+TEST(TestFenwickTree, TestSample)
+{
+	std::vector<float> weights(20, 0.0f);
+	weights[3] = 1.0f;
+	weights[17] = 3.0f;
+	Hax::FenwickTree tree;
+	tree.Assign(weights.data(), 20);
+
+	Hax::Random rng(1);
+	int counts[20] = {};
+	for (int i = 0; i < 4000; ++i)
+	{
+		++counts[tree.Sample(rng)];
+	}
+	EXPECT_EQ(counts[3] + counts[17], 4000);
+	EXPECT_NEAR(counts[17], 3000, 150);
+}
\ No newline at end of file
@@ -147,4 +147,50 @@ TEST(TestPathfinding, TestCheckWinStateGeneral2)
 	board.MakeMove(98);
 	board.MakeMove(27);
 	EXPECT_EQ(Hax::Pathfinding::CheckWinState(board, true), Hax::WinState::Black);
+}
+
+
+TEST(TestPathfinding, TestConnectionDistance)
+{
+	Hax::Board board(5);
+	EXPECT_EQ(Hax::Pathfinding::ConnectionDistance(board, true), 5);
+	EXPECT_EQ(Hax::Pathfinding::ConnectionDistance(board, false), 5);
+
+	int whiteMoves[] = { 0, 5, 10 };
+	int blackMoves[] = { 23, 24, 22 };
+	for (int i = 0; i < 3; ++i)
+	{
+		board.MakeMove(whiteMoves[i]);
+		board.MakeMove(blackMoves[i]);
+	}
+	EXPECT_EQ(Hax::Pathfinding::ConnectionDistance(board, true), 2);
+	EXPECT_EQ(Hax::Pathfinding::ConnectionDistance(board, false), 2);
+
+	//white's first column is complete, walling black off
+	board.MakeMove(15);
+	board.MakeMove(21);
+	board.MakeMove(20);
+	EXPECT_EQ(Hax::Pathfinding::ConnectionDistance(board, true), 0);
+	EXPECT_EQ(Hax::Pathfinding::ConnectionDistance(board, false), Hax::Pathfinding::UNREACHABLE);
+}
+
+
+TEST(TestPathfinding, TestEdgeDistances)
+{
+	Hax::Board board(3);
+	board.MakeMove(4);
+	int toStart[9];
+	int toEnd[9];
+
+	Hax::Pathfinding::EdgeDistances(board, true, toStart, toEnd);
+	EXPECT_EQ(toStart[0], 1);
+	EXPECT_EQ(toStart[4], 1);
+	EXPECT_EQ(toEnd[4], 1);
+	EXPECT_EQ(toStart[5], 2);
+
+	//white holds the centre, so black must go around it
+	Hax::Pathfinding::EdgeDistances(board, false, toStart, toEnd);
+	EXPECT_EQ(toStart[4], Hax::Pathfinding::UNREACHABLE);
+	EXPECT_EQ(toStart[3], 1);
+	EXPECT_EQ(toEnd[3], 3);
 }
\ No newline at end of file
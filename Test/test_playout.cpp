@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "playout.h"
+
+
+TEST(TestPlayout, TestNext)
+{
+	Hax::Board board(3);
+	board.MakeMove(4);
+	Hax::Playout::Settings settings;
+	settings.bridgeReply = 1.0f;
+	settings.lastGoodReply = true;
+	settings.patterns = true;
+	Hax::Playout::Policy policy(3, settings);
+	Hax::Random rng(1);
+	policy.SetMoves(board);
+	EXPECT_EQ(policy.Remaining(), 8);
+
+	//every empty cell is chosen exactly once
+	std::vector<bool> chosen(9, false);
+	while (policy.Remaining() > 0)
+	{
+		int move = policy.Next(board, -1, rng);
+		ASSERT_TRUE(board.IsLegalMove(move));
+		EXPECT_FALSE(chosen[move]);
+		chosen[move] = true;
+	}
+	EXPECT_EQ(std::count(chosen.begin(), chosen.end(), true), 8);
+
+	policy.Restart();
+	EXPECT_EQ(policy.Remaining(), 8);
+}
+
+
+TEST(TestPlayout, TestPattern)
+{
+	Hax::Board board(3);
+	Hax::Playout::Policy policy(3, Hax::Playout::Settings());
+	EXPECT_EQ(policy.Pattern(board, 4), 0);
+
+	//the top left corner borders White's edge above and Black's to the left
+	int white = (int)Hax::Hexagon::White;
+	int black = (int)Hax::Hexagon::Black;
+	EXPECT_EQ(policy.Pattern(board, 0), (white << 2) | (white << 4) | (black << 6) | (black << 8));
+
+	board.MakeMove(1);
+	EXPECT_EQ(policy.Pattern(board, 0) & 3, white);
+}
+
+
+TEST(TestPlayout, TestBridgeReply)
+{
+	Hax::Board board(5);
+	Hax::Playout::Settings settings;
+	settings.bridgeReply = 1.0f;
+	Hax::Playout::Policy policy(5, settings);
+
+	//white bridge between (1, 1) and (2, 2), carried by (2, 1) and (1, 2)
+	board.MakeMove(6);
+	board.MakeMove(24);
+	board.MakeMove(12);
+	EXPECT_EQ(policy.BridgeReply(board, 24), -1);
+	board.MakeMove(7);
+	EXPECT_EQ(policy.BridgeReply(board, 7), 11);
+
+	Hax::Random rng(1);
+	policy.SetMoves(board);
+	EXPECT_EQ(policy.Next(board, 7, rng), 11);
+
+	//bridge from (2, 1) to the top edge, carried by (2, 0) and (3, 0)
+	board = Hax::Board(5);
+	board.MakeMove(7);
+	board.MakeMove(2);
+	EXPECT_EQ(policy.BridgeReply(board, 2), 3);
+}
+
+
+TEST(TestPlayout, TestLastGoodReply)
+{
+	Hax::Board board(5);
+	Hax::Playout::Settings settings;
+	settings.lastGoodReply = true;
+	Hax::Playout::Policy policy(5, settings);
+
+	//black answered 12 with 13 and 0 with 5, and went on to win
+	policy.Learn(true, { 12, 13 }, { 0, 5 }, Hax::WinState::Black);
+	board.MakeMove(12);
+	EXPECT_EQ(policy.LastGoodReply(board, 12), 13);
+	EXPECT_EQ(policy.LastGoodReply(board, 0), 5);
+	EXPECT_EQ(policy.LastGoodReply(board, 3), -1);
+
+	Hax::Random rng(1);
+	policy.SetMoves(board);
+	EXPECT_EQ(policy.Next(board, 12, rng), 13);
+
+	//the reply is forgotten once it loses
+	policy.Learn(true, { 12, 13 }, {}, Hax::WinState::White);
+	EXPECT_EQ(policy.LastGoodReply(board, 12), -1);
+
+	//and never played on an occupied cell
+	policy.Learn(true, { 12, 13 }, {}, Hax::WinState::Black);
+	board.MakeMove(13);
+	board.MakeMove(14);
+	EXPECT_EQ(policy.LastGoodReply(board, 12), -1);
+
+	policy.Clear();
+	EXPECT_EQ(policy.LastGoodReply(board, 0), -1);
+}
+
+
+TEST(TestPlayout, TestWeight)
+{
+	int white = (int)Hax::Hexagon::White;
+	int black = (int)Hax::Hexagon::Black;
+	int contact = white | (black << 2);
+	int carrier = (white << 2) | (white << 10);
+	int dead = 0;
+	for (int d = 0; d < 6; ++d) dead |= white << (2 * d);
+
+	float plain = Hax::Playout::Policy::Weight(0, true);
+	EXPECT_GT(Hax::Playout::Policy::Weight(contact, true), plain);
+	EXPECT_LT(Hax::Playout::Policy::Weight(carrier, true), plain);
+	EXPECT_LT(Hax::Playout::Policy::Weight(carrier, false), plain);
+	EXPECT_LT(Hax::Playout::Policy::Weight(dead, false), plain);
+}
+
+TEST(TestPlayout, TestMast)
+{
+	Hax::Board board(3);
+	Hax::Playout::Settings settings;
+	settings.mast = true;
+	Hax::Playout::Policy policy(3, settings);
+	EXPECT_FLOAT_EQ(policy.MoveAverage(true, 4), 0.5f);
+
+	//white won both games after playing 4, and one of two after playing 0
+	policy.Learn(true, { 4, 1 }, { 0 }, Hax::WinState::White);
+	policy.Learn(true, { 4, 2 }, {}, Hax::WinState::White);
+	policy.Learn(true, { 0, 4 }, {}, Hax::WinState::Black);
+	EXPECT_FLOAT_EQ(policy.MoveAverage(true, 4), 1.0f);
+	EXPECT_FLOAT_EQ(policy.MoveAverage(true, 0), 0.5f);
+	EXPECT_FLOAT_EQ(policy.MoveAverage(false, 4), 1.0f);
+	EXPECT_FLOAT_EQ(policy.MoveAverage(false, 1), 0.0f);
+
+	Hax::Random rng(1);
+	policy.SetMoves(board);
+	int count = 0;
+	for (int i = 0; i < 100; ++i)
+	{
+		if (i > 0) policy.Restart();
+		if (policy.Next(board, -1, rng) == 4) ++count;
+	}
+	EXPECT_GT(count, 80);
+
+	//every move is still drawn exactly once per playout
+	std::vector<bool> seen(9, false);
+	policy.Restart();
+	while (policy.Remaining() > 0)
+	{
+		int move = policy.Next(board, -1, rng);
+		EXPECT_FALSE(seen[move]);
+		seen[move] = true;
+	}
+
+	//clearing forgets the averages, so draws are uniform again
+	policy.Clear();
+	EXPECT_FLOAT_EQ(policy.MoveAverage(true, 4), 0.5f);
+	policy.Restart();
+	count = 0;
+	for (int i = 0; i < 100; ++i)
+	{
+		if (i > 0) policy.Restart();
+		if (policy.Next(board, -1, rng) == 4) ++count;
+	}
+	EXPECT_LT(count, 40);
+}
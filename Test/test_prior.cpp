@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "prior.h"
+
+
+std::vector<int> LegalMoves(const Hax::Board& board)
+{
+	std::vector<int> moves;
+	for (int i = 0; i < board.Area(); ++i)
+	{
+		if (board.IsLegalMove(i)) moves.push_back(i);
+	}
+	return moves;
+}
+
+
+TEST(TestPrior, TestNone)
+{
+	Hax::Board board(5);
+	Hax::Prior::Scorer scorer(5, Hax::Prior::Kind::None);
+	std::vector<int> moves = LegalMoves(board);
+	std::vector<float> priors;
+	scorer.Score(board, -1, moves, priors);
+	ASSERT_EQ(priors.size(), moves.size());
+	EXPECT_EQ(std::count(priors.begin(), priors.end(), 0.0f), 25);
+}
+
+
+TEST(TestPrior, TestEdge)
+{
+	Hax::Board board(5);
+	Hax::Prior::Scorer scorer(5, Hax::Prior::Kind::Edge);
+	std::vector<float> priors;
+	scorer.Score(board, -1, { 0, 6, 12, 22 }, priors);
+	EXPECT_LT(priors[0], priors[1]);
+	EXPECT_LT(priors[1], priors[2]);
+	EXPECT_EQ(priors[2], 1.0f);
+	EXPECT_EQ(priors[3], priors[0]);
+}
+
+
+TEST(TestPrior, TestDistance)
+{
+	//white holds column 2 but for (2, 2) and (2, 4)
+	Hax::Board board(5);
+	for (int move : { 2, 0, 7, 5, 17, 10 })
+	{
+		board.MakeMove(move);
+	}
+
+	Hax::Prior::Scorer scorer(5, Hax::Prior::Kind::Distance);
+	std::vector<int> moves = LegalMoves(board);
+	std::vector<float> priors;
+	scorer.Score(board, 10, moves, priors);
+	for (size_t i = 0; i < moves.size(); ++i)
+	{
+		EXPECT_GE(priors[i], 0.0f);
+		EXPECT_LE(priors[i], 1.0f);
+		if (moves[i] == 12 || moves[i] == 22)
+		{
+			EXPECT_EQ(priors[i], 1.0f);
+		}
+		if (moves[i] == 24)
+		{
+			EXPECT_LT(priors[i], 1.0f);
+		}
+	}
+}
+
+
+TEST(TestPrior, TestBridge)
+{
+	Hax::Board board(5);
+	board.MakeMove(12);
+	board.MakeMove(0);
+	Hax::Prior::Scorer scorer(5, Hax::Prior::Kind::Bridge);
+	std::vector<float> priors;
+
+	//(3, 0) forms a bridge with (2, 2), and (3, 3) one with the bottom edge
+	scorer.Score(board, 0, { 3, 22, 18, 10 }, priors);
+	EXPECT_GT(priors[0], priors[1]);
+	EXPECT_GT(priors[2], priors[3]);
+
+	//restoring the bridge after black intrudes rates highest
+	board.MakeMove(3);
+	board.MakeMove(7);
+	scorer.Score(board, 7, { 8, 13, 18 }, priors);
+	EXPECT_EQ(priors[0], 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "random.h"
+#include <vector>
+
+
+TEST(TestRandom, TestDeterministic)
+{
+	Hax::Random a(42);
+	Hax::Random b(42);
+	Hax::Random c(43);
+	bool differs = false;
+	for (int i = 0; i < 100; ++i)
+	{
+		uint64_t x = a.Next();
+		EXPECT_EQ(x, b.Next());
+		if (x != c.Next()) differs = true;
+	}
+	EXPECT_TRUE(differs);
+}
+
+
+TEST(TestRandom, TestBounded)
+{
+	Hax::Random r(1);
+	std::vector<int> counts(7, 0);
+	for (int i = 0; i < 70000; ++i)
+	{
+		uint32_t x = r.Bounded(7);
+		ASSERT_LT(x, 7u);
+		++counts[x];
+	}
+
+	//every bucket should be hit roughly equally
+	for (int count : counts)
+	{
+		EXPECT_GT(count, 9000);
+		EXPECT_LT(count, 11000);
+	}
+
+	EXPECT_EQ(r.Bounded(1), 0u);
+}
+
+
+TEST(TestRandom, TestUniform)
+{
+	Hax::Random r(2);
+	for (int i = 0; i < 1000; ++i)
+	{
+		float x = r.Uniform();
+		EXPECT_GE(x, 0.0f);
+		EXPECT_LT(x, 1.0f);
+	}
+}
+
+
+TEST(TestRandom, TestJump)
+{
+	Hax::Random a(5);
+	Hax::Random b(5);
+	b.Jump();
+	EXPECT_NE(a.Next(), b.Next());
+
+	Hax::Random c(5);
+	c.Jump();
+	b = Hax::Random(5);
+	b.Jump();
+	EXPECT_EQ(b.Next(), c.Next());
+}
\ No newline at end of file
@@ -0,0 +1,528 @@
+#include "pch.h"
+#include "search.h"
+#include "random.h"
+#include "pathfinding.h"
+#include <cmath>
+#include <limits>
+#include <thread>
+
+
+namespace
+{
+	//Random child statistics, with about a third of the children unvisited
+	//and a third of those without AMAF data either.
+	void _RandomStats(Hax::Random& rng, int size, std::vector<float>& n, std::vector<float>& w,
+		std::vector<float>& nr, std::vector<float>& wr, std::vector<float>& prior)
+	{
+		n.resize(size);
+		w.resize(size);
+		nr.resize(size);
+		wr.resize(size);
+		prior.resize(size);
+		for (int i = 0; i < size; ++i)
+		{
+			n[i] = (rng.Bounded(3) == 0) ? 0.0f : (float)(1 + rng.Bounded(1000));
+			w[i] = std::floor(n[i] * rng.Uniform());
+			nr[i] = (n[i] == 0.0f && rng.Bounded(3) == 0) ? 0.0f : (float)rng.Bounded(5000);
+			wr[i] = std::floor(nr[i] * rng.Uniform());
+			prior[i] = rng.Uniform();
+		}
+	}
+}
+
+
+TEST(TestSearch, TestScoreAll)
+{
+	Hax::Random rng(7);
+	std::vector<float> n, w, nr, wr, prior, scores;
+	for (int trial = 0; trial < 40; ++trial)
+	{
+		Hax::Search::Params params;
+		params.expBias = 0.5f * (trial % 3);
+		params.b = 0.1f + rng.Uniform();
+		params.raveInit = trial % 2 == 0;
+		params.fpu = 0.8f + 0.1f * (trial % 4);
+		params.priorWeight = 2.0f;
+
+		//Sizes that are not a multiple of four exercise the scalar tail too.
+		int size = 1 + (int)rng.Bounded(60);
+		float N_i = 1.0f + (float)rng.Bounded(20000);
+		_RandomStats(rng, size, n, w, nr, wr, prior);
+		scores.resize(size);
+
+		const float* priors = (trial % 4 < 2) ? prior.data() : nullptr;
+		Hax::Search::_ScoreAll(n.data(), w.data(), nr.data(), wr.data(), priors, size, N_i, params, scores.data());
+		for (int i = 0; i < size; ++i)
+		{
+			float expected = Hax::Search::_Score(n[i], w[i], nr[i], wr[i], N_i, params);
+			if (priors) expected += params.priorWeight * prior[i] / (n[i] + 1.0f);
+			EXPECT_NEAR(scores[i], expected, 1e-5f * std::max(1.0f, std::fabs(expected))) << "trial " << trial << " child " << i;
+		}
+	}
+}
+
+
+TEST(TestSearch, TestArgMax)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+	EXPECT_EQ(Hax::Search::_ArgMax(nullptr, 0), -1);
+
+	std::vector<float> scores(11, -inf);
+	EXPECT_EQ(Hax::Search::_ArgMax(scores.data(), (int)scores.size()), -1);
+
+	//The first of tied highest scores wins, whether the tie is within a
+	//group of four, across groups or in the tail.
+	scores = { 0.1f, 0.5f, 0.2f, 0.5f, 0.3f, 0.5f, -inf, 0.0f, 0.4f, 0.5f, 0.5f };
+	EXPECT_EQ(Hax::Search::_ArgMax(scores.data(), (int)scores.size()), 1);
+	scores[1] = 0.0f;
+	EXPECT_EQ(Hax::Search::_ArgMax(scores.data(), (int)scores.size()), 3);
+	scores[3] = scores[5] = 0.0f;
+	EXPECT_EQ(Hax::Search::_ArgMax(scores.data(), (int)scores.size()), 9);
+
+	scores = { -inf, -inf, -inf, -inf, -inf, -2.0f };
+	EXPECT_EQ(Hax::Search::_ArgMax(scores.data(), (int)scores.size()), 5);
+}
+
+
+TEST(TestSearch, TestRootSync)
+{
+	//A root with the transposition table on, whose entries hold only the
+	//thread's own playouts, as after the search's backups.
+	Hax::Search::Params params;
+	params.expBias = 0.0f;
+	Hax::Search::TranspositionTable table(16);
+	Hax::Search::Node root;
+	Hax::Search::Children& children = root.children;
+	children.Add(1, 11, table.Insert(11));
+	children.Add(2, 12, table.Insert(12));
+	const float ownN[] = { 10.0f, 10.0f };
+	const float ownW[] = { 6.0f, 5.0f };
+	for (int i = 0; i < 2; ++i)
+	{
+		children.n[i] = children.entries[i]->n = ownN[i];
+		children.w[i] = children.entries[i]->w = ownW[i];
+	}
+	root.n = 20.0f;
+
+	std::vector<float> scratch;
+	EXPECT_EQ(Hax::Search::_SelectChild(root, params, false, scratch), 0);
+
+	//Syncing adds the other threads' statistics to the root's slots only,
+	//which favour the second move, so the root must select from its slots.
+	const float otherN[] = { 100.0f, 100.0f };
+	const float otherW[] = { 30.0f, 80.0f };
+	for (int i = 0; i < 2; ++i)
+	{
+		children.n[i] += otherN[i];
+		children.w[i] += otherW[i];
+	}
+	root.n += 200.0f;
+	EXPECT_EQ(Hax::Search::_SelectChild(root, params, false, scratch), 1);
+	EXPECT_EQ(Hax::Search::_SelectChild(root, params, true, scratch), 0);
+}
+
+
+TEST(TestSearch, TestShare)
+{
+	const long long shares[] = { 3, 3, 2, 2 };
+	for (int i = 0; i < 4; ++i)
+	{
+		EXPECT_EQ(Hax::Search::_Share(10, 4, i), shares[i]);
+		EXPECT_EQ(Hax::Search::_Share(0, 4, i), 0);
+
+		//zero would mean no limit, so small budgets give each thread one
+		EXPECT_EQ(Hax::Search::_Share(2, 4, i), 1);
+	}
+}
+
+
+TEST(TestSearch, TestEvaluate)
+{
+	Hax::Search::Params params;
+	params.truncateScale = 2.0f;
+	int margin = -1;
+
+	//level distances, so only the move counts: half a cell to the player to move
+	Hax::Board board(5);
+	EXPECT_FLOAT_EQ(Hax::Search::_Evaluate(board, params, margin), 1.0f / (1.0f + std::exp(-1.0f)));
+	EXPECT_EQ(margin, 0);
+
+	//White needs two cells down the middle column, Black still four
+	for (int move : { 2, 4, 7, 9, 12 })
+	{
+		board.MakeMove(move);
+	}
+
+	ASSERT_EQ(Hax::Pathfinding::ConnectionDistance(board, true), 2);
+	ASSERT_EQ(Hax::Pathfinding::ConnectionDistance(board, false), 4);
+	EXPECT_FALSE(board.WhiteToMove());
+	EXPECT_FLOAT_EQ(Hax::Search::_Evaluate(board, params, margin), 1.0f / (1.0f + std::exp(-3.0f)));
+	EXPECT_EQ(margin, 2);
+
+	//Black two cells ahead along the middle row, with White to move
+	Hax::Board mirror(5);
+	for (int move : { 20, 10, 21, 11, 22, 12 })
+	{
+		mirror.MakeMove(move);
+	}
+
+	ASSERT_EQ(Hax::Pathfinding::ConnectionDistance(mirror, false), 2);
+	ASSERT_EQ(Hax::Pathfinding::ConnectionDistance(mirror, true), 4);
+	EXPECT_TRUE(mirror.WhiteToMove());
+	EXPECT_FLOAT_EQ(Hax::Search::_Evaluate(mirror, params, margin), 1.0f / (1.0f + std::exp(3.0f)));
+	EXPECT_EQ(margin, 2);
+}
+
+
+namespace
+{
+	//Parameters for reproducible test searches: no exact solver and no
+	//time-dependent root sync.
+	Hax::Search::Params _TestParams()
+	{
+		Hax::Search::Params params;
+		params.expBias = 0.5f;
+		params.solverEmpties = 0;
+		return params;
+	}
+
+
+	Hax::Search::Limits _Playouts(long long playouts)
+	{
+		Hax::Search::Limits limits;
+		limits.playouts = playouts;
+		return limits;
+	}
+
+
+	float _TotalVisits(const Hax::Search::Searcher& searcher)
+	{
+		float total = 0.0f;
+		for (const Hax::Search::MoveStats& stats : searcher.Merged())
+		{
+			total += stats.n;
+		}
+		return total;
+	}
+}
+
+
+TEST(TestSearcher, TestReroot)
+{
+	Hax::Board board(5);
+	Hax::Search::Searcher searcher(board, 1, _TestParams());
+	searcher.Seed(1);
+	int move = searcher.Search(_Playouts(2000));
+	ASSERT_TRUE(board.IsLegalMove(move));
+
+	//the subtree under the move played is kept, so a one playout search
+	//already has the statistics of earlier ones
+	searcher.MakeMove(move);
+	searcher.Search(_Playouts(1));
+	EXPECT_GT(_TotalVisits(searcher), 10.0f);
+
+	//an unrelated position starts from scratch
+	Hax::Board other(5);
+	other.MakeMove(0);
+	other.MakeMove(24);
+	searcher.SetPosition(other);
+	searcher.Search(_Playouts(1));
+	EXPECT_EQ(_TotalVisits(searcher), 1.0f);
+}
+
+
+TEST(TestSearcher, TestSeed)
+{
+	Hax::Board board(5);
+	Hax::Search::Params params = _TestParams();
+	params.transpositionEntries = 1024;
+	params.lastGoodReply = true;
+	Hax::Search::Searcher first(board, 2, params);
+	Hax::Search::Searcher second(board, 2, params);
+	first.Seed(42);
+	second.Seed(42);
+	int move = first.Search(_Playouts(1000));
+	std::vector<Hax::Search::MoveStats> merged = first.Merged();
+	EXPECT_EQ(second.Search(_Playouts(1000)), move);
+
+	//the same seed gives the same search, whatever was searched before
+	first.Search(_Playouts(1000));
+	first.Seed(42);
+	EXPECT_EQ(first.Search(_Playouts(1000)), move);
+	for (const std::vector<Hax::Search::MoveStats>* stats : { &first.Merged(), &second.Merged() })
+	{
+		ASSERT_EQ(stats->size(), merged.size());
+		for (size_t i = 0; i < merged.size(); ++i)
+		{
+			EXPECT_EQ((*stats)[i].move, merged[i].move);
+			EXPECT_EQ((*stats)[i].n, merged[i].n);
+			EXPECT_EQ((*stats)[i].w, merged[i].w);
+		}
+	}
+}
+
+
+TEST(TestSearcher, TestSolver)
+{
+	//white, to move, connects top to bottom by playing 6 or 7
+	Hax::Board board(3);
+	for (int move : { 1, 0, 4, 3 })
+	{
+		board.MakeMove(move);
+	}
+
+	Hax::Search::Searcher searcher(board, 1, _TestParams());
+	searcher.Seed(1);
+	int move = searcher.Search(_Playouts(5000));
+	EXPECT_TRUE(move == 6 || move == 7);
+	EXPECT_FALSE(searcher.Info().solved);
+	bool proven = false;
+	for (const Hax::Search::MoveStats& stats : searcher.Merged())
+	{
+		if (stats.move == move) proven = stats.proof == Hax::Search::Proof::Win;
+	}
+	EXPECT_TRUE(proven);
+
+	//without a budget, the first thread to solve the root ends the search
+	Hax::Search::Searcher threads(board, 4, _TestParams());
+	Hax::Search::Limits limits;
+	limits.time = 2000;
+	move = threads.Search(limits);
+	EXPECT_TRUE(move == 6 || move == 7);
+	EXPECT_LT(threads.Info().elapsed, 1000);
+
+	//the exact solver finds the same
+	Hax::Search::Params params = _TestParams();
+	params.solverEmpties = 9;
+	Hax::Search::Searcher solver(board, 1, params);
+	move = solver.Search(_Playouts(5000));
+	EXPECT_TRUE(move == 6 || move == 7);
+	EXPECT_TRUE(solver.Info().solved);
+}
+
+
+TEST(TestSearcher, TestSymmetry)
+{
+	//the empty board is unchanged by a half turn, so only one move of each
+	//pair the half turn swaps is searched at the root
+	Hax::Board board(4);
+	const int last = board.Area() - 1;
+	Hax::Search::Searcher pruned(board, 1, _TestParams());
+	pruned.Seed(1);
+	pruned.Search(_Playouts(2000));
+	for (const Hax::Search::MoveStats& stats : pruned.Merged())
+	{
+		if (stats.move > last - stats.move) EXPECT_EQ(stats.n, 0.0f);
+		else EXPECT_GT(stats.n, 0.0f);
+	}
+
+	Hax::Search::Params params = _TestParams();
+	params.symmetryDepth = 0;
+	Hax::Search::Searcher full(board, 1, params);
+	full.Seed(1);
+	full.Search(_Playouts(2000));
+	for (const Hax::Search::MoveStats& stats : full.Merged())
+	{
+		EXPECT_GT(stats.n, 0.0f);
+	}
+}
+
+
+TEST(TestSearcher, TestStop)
+{
+	//stopping from another thread ends the search, the exact solver included,
+	//long before any limit
+	Hax::Board board(7);
+	Hax::Search::Params params = _TestParams();
+	params.solverEmpties = board.Area();
+	params.solverNodes = 1LL << 40;
+	Hax::Search::Searcher searcher(board, 2, params);
+	Hax::Search::Limits limits;
+	limits.time = 20000;
+	limits.playouts = 1LL << 40;
+	std::atomic<bool> stop(false);
+	std::thread stopper([&stop]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			stop = true;
+		});
+	int move = searcher.Search(limits, stop);
+	stopper.join();
+	EXPECT_TRUE(board.IsLegalMove(move));
+	EXPECT_LT(searcher.Info().elapsed, 500);
+}
+
+
+TEST(TestSearcher, TestDeadline)
+{
+	//every thread stops at the shared deadline
+	Hax::Board board(7);
+	Hax::Search::Params params = _TestParams();
+	params.earlyStop = false;
+	Hax::Search::Searcher searcher(board, 2, params);
+	searcher.Search(200);
+	EXPECT_GE(searcher.Info().elapsed, 200);
+	EXPECT_LT(searcher.Info().elapsed, 500);
+	EXPECT_GT(searcher.Info().playouts, 0);
+}
+
+
+TEST(TestSearcher, TestEarlyStop)
+{
+	//white, to move, wins at once by playing 22, so that move soon has a
+	//lead the rest of the time could not overturn
+	Hax::Board board(5);
+	for (int move : { 2, 0, 7, 5, 12, 10, 17, 21 })
+	{
+		board.MakeMove(move);
+	}
+
+	Hax::Search::Params params = _TestParams();
+	params.expBias = 0.0f;
+	params.solver = false;
+	params.decision = Hax::Search::Decision::MaxVisits;
+	Hax::Search::Searcher searcher(board, 2, params);
+	EXPECT_EQ(searcher.Search(1000), 22);
+	EXPECT_GT(searcher.Info().saved, 0);
+	EXPECT_LT(searcher.Info().elapsed, 1000);
+
+	//the visit lead settles nothing for other decision rules
+	params.decision = Hax::Search::Decision::MaxLcb;
+	Hax::Search::Searcher lcb(board, 2, params);
+	EXPECT_EQ(lcb.Search(300), 22);
+	EXPECT_EQ(lcb.Info().saved, 0);
+	EXPECT_GE(lcb.Info().elapsed, 300);
+}
+
+
+TEST(TestSearcher, TestPonder)
+{
+	Hax::Board board(7);
+	Hax::Search::Searcher searcher(board, 2, _TestParams());
+
+	//pondering grows the tree the next search starts from
+	searcher.StartPondering();
+	EXPECT_TRUE(searcher.IsPondering());
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	searcher.StopPondering();
+	EXPECT_FALSE(searcher.IsPondering());
+	searcher.Search(_Playouts(2));
+	float pondered = _TotalVisits(searcher);
+	EXPECT_GT(pondered, 100.0f);
+
+	//a move played while pondering stops it and keeps the subtree below
+	searcher.StartPondering();
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	searcher.MakeMove(24);
+	EXPECT_FALSE(searcher.IsPondering());
+	searcher.Search(_Playouts(2));
+	EXPECT_GT(_TotalVisits(searcher), 10.0f);
+}
+
+
+TEST(TestSearcher, TestPortfolio)
+{
+	//two threads with different parameters, whose trees are reproduced by
+	//single-thread searchers with each entry and seed on its own
+	Hax::Board board(5);
+	std::vector<Hax::Search::Params> portfolio(2, _TestParams());
+	portfolio[1].expBias = 1.5f;
+	portfolio[1].lastGoodReply = true;
+	//search-wide settings come from the first entry alone
+	portfolio[1].solverEmpties = board.Area();
+	portfolio[1].decision = Hax::Search::Decision::MaxVisits;
+
+	Hax::Search::Searcher searcher(board, 2, portfolio);
+	searcher.Seed(std::vector<uint64_t>{ 5, 6 });
+	int move = searcher.Search(_Playouts(2000));
+	EXPECT_FALSE(searcher.Info().solved);
+
+	float votes = 0.0f;
+	std::vector<float> n(board.Area(), 0.0f);
+	for (int i = 0; i < 2; ++i)
+	{
+		Hax::Search::Params params = portfolio[i];
+		params.solverEmpties = 0;
+		Hax::Search::Searcher single(board, 1, params);
+		single.Seed(std::vector<uint64_t>{ (uint64_t)(5 + i) });
+		single.Search(_Playouts(1000));
+
+		//each tree votes for its most visited move with that move's LCB
+		const Hax::Search::MoveStats* best = nullptr;
+		for (const Hax::Search::MoveStats& stats : single.Merged())
+		{
+			n[stats.move] += stats.n;
+			if (!best || stats.n > best->n) best = &stats;
+		}
+		votes += Hax::Search::_Lcb(best->w, best->n);
+	}
+
+	float total = 0.0f;
+	const Hax::Search::MoveStats* elected = nullptr;
+	for (const Hax::Search::MoveStats& stats : searcher.Merged())
+	{
+		EXPECT_EQ(stats.n, n[stats.move]);
+		total += stats.votes;
+		if (!elected || stats.votes > elected->votes) elected = &stats;
+	}
+	EXPECT_FLOAT_EQ(total, votes);
+
+	//with more than one entry the default decision is the vote
+	ASSERT_NE(elected, nullptr);
+	EXPECT_EQ(move, elected->move);
+}
+
+
+TEST(TestSearcher, TestLeafPlayouts)
+{
+	//every leaf reached backs up k playouts at once, so a budget is rounded
+	//up to a whole number of leaves
+	Hax::Board board(7);
+	Hax::Search::Params params = _TestParams();
+	params.leafPlayouts = 4;
+	const long long budgets[] = { 1, 4, 5, 8, 9, 100 };
+	const long long made[] = { 4, 4, 8, 8, 12, 100 };
+	for (int i = 0; i < 6; ++i)
+	{
+		Hax::Search::Searcher searcher(board, 1, params);
+		searcher.Seed(1);
+		searcher.Search(_Playouts(budgets[i]));
+		EXPECT_EQ(searcher.Info().playouts, made[i]);
+		EXPECT_EQ(_TotalVisits(searcher), (float)made[i]);
+		for (const Hax::Search::MoveStats& stats : searcher.Merged())
+		{
+			EXPECT_EQ(std::fmod(stats.n, 4.0f), 0.0f);
+		}
+	}
+}
+
+
+TEST(TestSearcher, TestFirstPlayUrgency)
+{
+	//Without first-play urgency every root move is tried once before any is
+	//tried again. With a low fpu the search keeps returning to visited moves,
+	//descending below them while some root moves are still untried.
+	Hax::Board board(7);
+	Hax::Search::Params params = _TestParams();
+	params.raveInit = false;
+	params.fpu = 0.0f;
+	for (bool urgency : { false, true })
+	{
+		params.firstPlayUrgency = urgency;
+		Hax::Search::Searcher searcher(board, 1, params);
+		searcher.Seed(1);
+		searcher.Search(_Playouts(20));
+
+		float most = 0.0f;
+		int untried = 0;
+		for (const Hax::Search::MoveStats& stats : searcher.Merged())
+		{
+			most = std::max(most, stats.n);
+			if (stats.n == 0.0f) ++untried;
+		}
+
+		EXPECT_GT(untried, 0);
+		if (urgency) EXPECT_GT(most, 1.0f);
+		else EXPECT_EQ(most, 1.0f);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "solver.h"
+#include "random.h"
+
+
+//Plain minimax over every move, for checking the solver against.
+bool _MinimaxWins(Hax::Board& board)
+{
+	Hax::WinState mine = (board.WhiteToMove()) ? Hax::WinState::White : Hax::WinState::Black;
+	for (int i = 0; i < board.Area(); ++i)
+	{
+		if (!board.IsLegalMove(i)) continue;
+		board.MakeMove(i);
+		Hax::WinState state = Hax::Pathfinding::CheckWinState(board);
+		bool win = state == mine || (state == Hax::WinState::Ongoing && !_MinimaxWins(board));
+		board.UndoMove(i);
+		if (win) return true;
+	}
+	return false;
+}
+
+
+TEST(TestSolver, TestSmallBoards)
+{
+	//the first player wins on every empty board
+	for (int length = 2; length <= 4; ++length)
+	{
+		Hax::Board board(length);
+		Hax::Solver::Result result = Hax::Solver::Solve(board, 10000000);
+		EXPECT_EQ(result.outcome, Hax::Solver::Outcome::Win);
+		ASSERT_TRUE(board.IsLegalMove(result.move));
+
+		board.MakeMove(result.move);
+		EXPECT_EQ(Hax::Solver::Solve(board, 10000000).outcome, Hax::Solver::Outcome::Loss);
+	}
+}
+
+
+TEST(TestSolver, TestImmediateWin)
+{
+	//white connects top to bottom down the first column but for one cell
+	Hax::Board board(5);
+	int whiteMoves[] = { 0, 5, 10, 20 };
+	int blackMoves[] = { 2, 7, 12, 17 };
+	for (int i = 0; i < 4; ++i)
+	{
+		board.MakeMove(whiteMoves[i]);
+		board.MakeMove(blackMoves[i]);
+	}
+
+	Hax::Solver::Result result = Hax::Solver::Solve(board, 1000);
+	EXPECT_EQ(result.outcome, Hax::Solver::Outcome::Win);
+	EXPECT_EQ(result.move, 15);
+	EXPECT_EQ(result.nodes, 1);
+}
+
+
+TEST(TestSolver, TestMatchesMinimax)
+{
+	Hax::Random rng(7);
+	for (int game = 0; game < 50; ++game)
+	{
+		Hax::Board board(4);
+		Hax::WinState state = Hax::WinState::Ongoing;
+		while (board.CountUnoccupied() > 7 && state == Hax::WinState::Ongoing)
+		{
+			int move = rng.Bounded(board.Area());
+			if (!board.IsLegalMove(move)) continue;
+			board.MakeMove(move);
+			state = Hax::Pathfinding::CheckWinState(board);
+		}
+		if (state != Hax::WinState::Ongoing) continue;
+
+		Hax::Solver::Result result = Hax::Solver::Solve(board, 10000000);
+		bool wins = _MinimaxWins(board);
+		EXPECT_EQ(result.outcome, (wins) ? Hax::Solver::Outcome::Win : Hax::Solver::Outcome::Loss);
+		if (!wins) continue;
+
+		ASSERT_TRUE(board.IsLegalMove(result.move));
+		board.MakeMove(result.move);
+		EXPECT_TRUE(Hax::Pathfinding::CheckWinState(board) != Hax::WinState::Ongoing || !_MinimaxWins(board));
+	}
+}
+
+
+TEST(TestSolver, TestBudget)
+{
+	Hax::Board board(6);
+	Hax::Solver::Result result = Hax::Solver::Solve(board, 100);
+	EXPECT_EQ(result.outcome, Hax::Solver::Outcome::Unknown);
+	EXPECT_EQ(result.move, -1);
+}
+
+
+TEST(TestSolver, TestStop)
+{
+	Hax::Board board(6);
+	std::atomic<bool> stop(true);
+	Hax::Solver::Table table;
+	Hax::Solver::Result result = Hax::Solver::Solve(board, 10000000, std::chrono::steady_clock::time_point::max(), stop, table);
+	EXPECT_EQ(result.outcome, Hax::Solver::Outcome::Unknown);
+	EXPECT_EQ(result.nodes, 1);
+}
+
+
+TEST(TestSolver, TestTable)
+{
+	//a table given to a later call answers the positions already solved
+	Hax::Board board(4);
+	std::atomic<bool> stop(false);
+	Hax::Solver::Table table;
+	std::chrono::steady_clock::time_point never = std::chrono::steady_clock::time_point::max();
+	Hax::Solver::Result first = Hax::Solver::Solve(board, 10000000, never, stop, table);
+	ASSERT_EQ(first.outcome, Hax::Solver::Outcome::Win);
+	EXPECT_GT(first.nodes, 1);
+
+	Hax::Solver::Result second = Hax::Solver::Solve(board, 10000000, never, stop, table);
+	EXPECT_EQ(second.outcome, Hax::Solver::Outcome::Win);
+	EXPECT_EQ(second.move, first.move);
+	EXPECT_EQ(second.nodes, 1);
+
+	//so is the position after the winning move, which the proof covered
+	board.MakeMove(first.move);
+	Hax::Solver::Result reply = Hax::Solver::Solve(board, 10000000, never, stop, table);
+	EXPECT_EQ(reply.outcome, Hax::Solver::Outcome::Loss);
+	EXPECT_EQ(reply.nodes, 1);
+}
\ No newline at end of file
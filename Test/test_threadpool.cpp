@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "threadpool.h"
+#include <atomic>
 
 
 TEST(TestThreadpool, TestConstruct)
@@ -54,4 +55,44 @@ TEST(TestThreadpool, TestSubmitExcessWaits)
 	{
 		EXPECT_TRUE(running[i]);
 	}
+}
+
+
+TEST(TestThreadpool, TestReuse)
+{
+	std::atomic<int> done(0);
+	Hax::Threadpool threadpool(4);
+	for (int round = 1; round <= 3; ++round)
+	{
+		for (int i = 0; i < 10; ++i)
+		{
+			threadpool.Submit([&done]() { ++done; });
+		}
+
+		threadpool.WaitAll();
+		EXPECT_EQ(done, 10 * round);
+		EXPECT_EQ(threadpool.NumActive(), 0);
+	}
+}
+
+
+TEST(TestThreadpool, TestShutdown)
+{
+	//the destructor lets tasks still running or queued finish
+	std::atomic<int> done(0);
+	{
+		Hax::Threadpool threadpool(2);
+		for (int i = 0; i < 4; ++i)
+		{
+			threadpool.Submit([&done]()
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(50));
+					++done;
+				});
+		}
+
+		EXPECT_LT(done, 4);
+	}
+
+	EXPECT_EQ(done, 4);
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "pch.h"
+#include "transposition.h"
+
+
+TEST(TestTranspositionTable, TestConstruct)
+{
+	Hax::Search::TranspositionTable table(100);
+	EXPECT_GE(table.Size(), 100u);
+	EXPECT_EQ(table.Size() % Hax::Search::TranspositionTable::BUCKET_SIZE, 0u);
+}
+
+
+TEST(TestTranspositionTable, TestInsertFind)
+{
+	Hax::Search::TranspositionTable table(64);
+	EXPECT_EQ(table.Find(12345), nullptr);
+
+	Hax::Search::TTEntry* entry = table.Insert(12345);
+	ASSERT_NE(entry, nullptr);
+	EXPECT_EQ(entry->key, 12345u);
+	entry->n = 3.0f;
+
+	EXPECT_EQ(table.Find(12345), entry);
+	EXPECT_EQ(table.Insert(12345), entry);
+	EXPECT_EQ(table.Find(12345)->n, 3.0f);
+
+	table.Clear();
+	EXPECT_EQ(table.Find(12345), nullptr);
+}
+
+
+TEST(TestTranspositionTable, TestReplacement)
+{
+	//a single bucket, so every key competes for the same entries
+	Hax::Search::TranspositionTable table(1);
+	const size_t size = Hax::Search::TranspositionTable::BUCKET_SIZE;
+	for (size_t i = 1; i <= size; ++i)
+	{
+		table.Insert(i)->n = (float)(10 * i);
+	}
+
+	//the least visited entry (key 1) is evicted
+	table.Insert(size + 1);
+	EXPECT_EQ(table.Find(1), nullptr);
+	for (size_t i = 2; i <= size + 1; ++i)
+	{
+		EXPECT_NE(table.Find(i), nullptr);
+	}
+}
\ No newline at end of file
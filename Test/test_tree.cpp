@@ -122,6 +122,27 @@ TEST(TestTree, TestRoaming)
 }
 
 
+TEST(TestTree, TestReroot)
+{
+	DefaultTree<int> t(0);
+	t.Insert(1, 10);
+	t.Insert(2, 20);
+	t.Descend(1);
+	t.Insert(3, 30);
+	t.Ascend();
+
+	t.Reroot(1);
+	EXPECT_TRUE(t.IsRoot());
+	EXPECT_EQ(t.Data(), 10);
+	EXPECT_EQ(t.Size(), 1);
+	EXPECT_TRUE(t.HasChild(3));
+
+	t.Descend(3);
+	t.Ascend();
+	EXPECT_TRUE(t.IsRoot());
+}
+
+
 TEST_F(MoveSemanticsFixture, TestMoveSemantics)
 {
 	Moveable m(c, 1);